@@ -33,6 +33,32 @@
 
 // DebugSettings approach
 #include "llviewerVR.vrmod_settings.c++" // gVrModSettings
+#include "llviewerVR.vrmod_telemetry.c++" // gVrModTelemetry
+#include "llviewerVR.vrmod_projection.c++" // gVrModProjection
+#include "llviewerVR.vrmod_pointer.c++" // gVrModPointer
+#include "llviewerVR.vrmod_input.c++" // gVrModInput
+#include "llviewerVR.vrmod_overlay.c++" // gVrModOverlay
+#include "llviewerVR.vrmod_ui.c++" // gVrModUiLayer
+#include "llviewerVR.vrmod_farfield.c++" // gVrModFarField
+#include "llviewerVR.vrmod_cull.c++" // gVrModCull
+#include "llviewerVR.vrmod_passes.c++" // gVrModPasses
+#include "llviewerVR.vrmod_posetrace.c++" // gVrModPoseTrace
+#include "llviewerVR.vrmod_capture.c++" // gVrModCapture
+#include "llviewerVR.vrmod_runtime.c++" // gVrModOpenVR
+#include "llviewerVR.vrmod_hitch.c++" // gVrModHitch
+
+// OpenVR runtime discovery (reading + parsing openvrpaths.vrpath) is cached by
+// openvr_api; warm that cache in the background at startup so the first
+// Ctrl+TAB doesn't pay for it (settings are instrumented first, same pounceable)
+#include <future>
+std::future<bool> gVrRuntimeDiscovery;
+const bool gVrRuntimeDiscoveryPending = []{
+	gMessageSystem.callWhenReady([](auto) {
+		if (gVrModSettings && gVrModSettings->discoverAtStartup)
+			gVrRuntimeDiscovery = std::async(std::launch::async, openvr_api::prefetchRuntimePaths);
+	});
+	return true;
+}();
 
 //#include <time.h>
 //#include <sys/time.h>
@@ -90,7 +116,7 @@ void llviewerVR::calcUVBounds(vr::EVREye eye, F32 *uMin, F32 *uMax, F32 *vMin, F
 	F32 vrTanAngleRight = 0.0;
 	F32 vrTanAngleUp = 0.0;
 	F32 vrTanAngleDown = 0.0;
-	gHMD->GetProjectionRaw(eye, &vrTanAngleLeft, &vrTanAngleRight, &vrTanAngleDown, &vrTanAngleUp); // Valve documentation backwards?
+	m_pRuntime->projectionRaw(eye, &vrTanAngleLeft, &vrTanAngleRight, &vrTanAngleDown, &vrTanAngleUp); // Valve documentation backwards?
 	F32 vrTanAngleWidth = vrTanAngleRight - vrTanAngleLeft;
 	F32 vrTanAngleHeight = vrTanAngleUp - vrTanAngleDown;
 
@@ -112,7 +138,7 @@ void llviewerVR::calcUVBounds(vr::EVREye eye, F32 *uMin, F32 *uMax, F32 *vMin, F
 }
 
 F32 llviewerVR::eyeDistance() {
-	vr::HmdMatrix34_t mat = gHMD->GetEyeToHeadTransform(vr::Eye_Right);
+	vr::HmdMatrix34_t mat = m_pRuntime->eyeToHead(vr::Eye_Right);
 	return 2000.0 * mat.m[0][3];
 }
 
@@ -198,10 +224,10 @@ glh::matrix4f llviewerVR::ConvertSteamVRMatrixToMatrix42(const vr::HmdMatrix34_t
 
 glh::matrix4f llviewerVR::GetHMDMatrixProjectionEye(vr::Hmd_Eye nEye)
 {
-	if (gHMD == NULL)
+	if (m_pRuntime == NULL)
 		return glh::matrix4f();
 
-	vr::HmdMatrix44_t mat = gHMD->GetProjectionMatrix(nEye, m_fNearClip, m_fFarClip);
+	vr::HmdMatrix44_t mat = m_pRuntime->projectionMatrix(nEye, m_fNearClip, m_fFarClip);
 
 	return glh::matrix4f(
 		mat.m[0][0], mat.m[1][0], mat.m[2][0], mat.m[3][0],
@@ -213,10 +239,10 @@ glh::matrix4f llviewerVR::GetHMDMatrixProjectionEye(vr::Hmd_Eye nEye)
 
 glh::matrix4f llviewerVR::GetHMDMatrixPoseEye(vr::Hmd_Eye nEye)
 {
-	if (gHMD == NULL)
+	if (m_pRuntime == NULL)
 		return glh::matrix4f();
 
-	vr::HmdMatrix34_t matEyeRight = gHMD->GetEyeToHeadTransform(nEye);
+	vr::HmdMatrix34_t matEyeRight = m_pRuntime->eyeToHead(nEye);
 	return glh::matrix4f(
 		matEyeRight.m[0][0], matEyeRight.m[1][0], matEyeRight.m[2][0], 0.0,
 		matEyeRight.m[0][1], matEyeRight.m[1][1], matEyeRight.m[2][1], 0.0,
@@ -234,7 +260,7 @@ glh::matrix4f llviewerVR::GetHMDMatrixPoseEye(vr::Hmd_Eye nEye)
 //Copy both matrices at startup?????
 glh::matrix4f llviewerVR::GetCurrentViewProjectionMatrix(vr::Hmd_Eye nEye)
 {
-	if (gHMD == NULL)
+	if (m_pRuntime == NULL)
 		return glh::matrix4f();
 	return GetHMDMatrixProjectionEye(nEye) * GetHMDMatrixPoseEye(nEye) * m_mat4HMDPose;
 }
@@ -488,7 +514,7 @@ bool llviewerVR::gluInvertMatrix(const float m[16], float invOut[16])
 
 void llviewerVR::UpdateHMDMatrixPose()
 {
-	if (gHMD == NULL)
+	if (m_pRuntime == NULL)
 		return;
 	/// for somebody asking for the default figure out the time from now to photons.
 	/*	float fSecondsSinceLastVsync;
@@ -503,7 +529,8 @@ void llviewerVR::UpdateHMDMatrixPose()
 	
 	
 	
-	vr::VRCompositor()->WaitGetPoses(gTrackedDevicePose, vr::k_unMaxTrackedDeviceCount, NULL, 0);
+	m_pRuntime->waitFrame(gTrackedDevicePose);
+	gVrModPoseTrace.frame(gTrackedDevicePose);
 
 	m_iValidPoseCount = 0;
 	m_strPoseClasses = "";
@@ -515,7 +542,7 @@ void llviewerVR::UpdateHMDMatrixPose()
 			m_rmat4DevicePose[nDevice] = ConvertSteamVRMatrixToMatrix42(gTrackedDevicePose[nDevice].mDeviceToAbsoluteTracking);
 			if (m_rDevClassChar[nDevice] == 0)
 			{
-				switch (gHMD->GetTrackedDeviceClass(nDevice))
+				switch (m_pRuntime->deviceClass(nDevice))
 				{
 				case vr::TrackedDeviceClass_Controller:        m_rDevClassChar[nDevice] = 'C'; break;
 				case vr::TrackedDeviceClass_HMD:               m_rDevClassChar[nDevice] = 'H'; break;
@@ -637,99 +664,37 @@ void llviewerVR::vrStartup(bool is_shutdown)
 
 	if (m_bVrEnabled && !is_shutdown)
 	{
-		if (gHMD == NULL)
+		if (m_pRuntime == NULL && !m_fStartup.valid())
 		{
+			VrModRuntime *runtime = &gVrModOpenVR;
+			// everything that talks to the runtime happens on a worker; the
+			// render thread only creates the eye framebuffers (PollStartup)
+			gVrModTelemetry.startupBegin();
 			gVRInitComplete = FALSE;
-			vr::EVRInitError eError = vr::VRInitError_None;
-			gHMD = vr::VR_Init(&eError, vr::VRApplication_Scene);
-			m_strHudText="Initializing VR driver!";
-			//hud_textp->setString(m_strHudText);
-
-			if (eError != vr::VRInitError_None)
-			{
-				gHMD = NULL;
-				char buf[1024];
-				sprintf_s(buf, sizeof(buf), "\nERROR Unable to init VR runtime: %s", vr::VR_GetVRInitErrorAsEnglishDescription(eError));
-				m_strHudText.append( buf);
-				//return false;
-			}
-			else
-			{
-				m_strDriver = "No Driver";
-				m_strDisplay = "No Display";
-
-				m_strDriver = GetTrackedDeviceString(gHMD, vr::k_unTrackedDeviceIndex_Hmd, vr::Prop_TrackingSystemName_String);
-				m_strDisplay = GetTrackedDeviceString(gHMD, vr::k_unTrackedDeviceIndex_Hmd, vr::Prop_SerialNumber_String);
-				m_strHudText.append("\nDriver = ");
-				m_strHudText.append(m_strDriver);
-				m_strHudText.append("\nDisplay = ");
-				m_strHudText.append(m_strDriver);
-				m_strHudText.append("\nVR driver! Initialized");
-
-			}
-
-			eError = vr::VRInitError_None;
-			if (gHMD != NULL)
-				gRenderModels = (vr::IVRRenderModels *)vr::VR_GetGenericInterface(vr::IVRRenderModels_Version, &eError);
-
-			if (!gRenderModels)
-			{
-				gHMD = NULL;
-				vr::VR_Shutdown();
-
-				char buf[1024];
-				sprintf_s(buf, sizeof(buf), "\nERROR Unable to get render model interface: %s", vr::VR_GetVRInitErrorAsEnglishDescription(eError));
-				m_strHudText.append(buf);
-				//SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, "VR_Init Failed", buf, NULL);
-				//return false;
-			}
-			eError = vr::VRInitError_None;
-
-			if (!vr::VRCompositor())
-			{
-
-				char buf[1024];
-				sprintf_s(buf, sizeof(buf), "\nERROR No compositor interface: %s", vr::VR_GetVRInitErrorAsEnglishDescription(eError));
-				m_strHudText.append(buf);
-				gHMD = NULL;
-				vr::VR_Shutdown();
-
-			}
-			if (gHMD != NULL && !gVRInitComplete)
-			{
-				gVRInitComplete = TRUE;
-				vr::VRCompositor()->SetTrackingSpace(vr::TrackingUniverseSeated);
-				gHMD->GetRecommendedRenderTargetSize(&m_nRenderWidth, &m_nRenderHeight);
-				
-				//m_nRenderHeight	=	1440;
-				//m_nRenderWidth	=	1440;
-				//if (leftEyeDesc.m_nResolveTextureId == NULL)
-				CreateFrameBuffer(m_nRenderWidth, m_nRenderHeight, leftEyeDesc);
-				//if (rightEyeDesc.m_nResolveTextureId == NULL)
-				CreateFrameBuffer(m_nRenderWidth, m_nRenderHeight, rightEyeDesc);
-				SetupCameras();
-				//vr::VRCompositor()->ForceInterleavedReprojectionOn(true);
-				//vr::VRCompositor()->SetTrackingSpace(vr::);
-				//m_tTimer1.start();
-				
-				m_strHudText.append("\nCreating frame buffers.");
-				
-				
-				
-				
-			}
-			if(gVRInitComplete)
-				m_strHudText.append("\nVR driver ready.\n Press TAB to enter VR mode.");
-			hud_textp->setString(m_strHudText);
+			m_iStartupStage = STARTUP_LOADING_RUNTIME;
 			m_strHudText = "";
-			hud_textp->setDoFade(FALSE);
-			hud_textp->setHidden(FALSE);
+			m_fStartup = std::async(std::launch::async, [this, runtime] { return vrStartupWorker(runtime); });
+			gVrModTelemetry.startupKicked();
 		}
 	}
-	else if (gHMD || is_shutdown)
+	else if (m_pRuntime || is_shutdown || m_fStartup.valid())
 	{
 		m_bVrActive = FALSE;
-		vr::VR_Shutdown();
+		VrModRuntime *runtime = m_pRuntime;
+		if (m_fStartup.valid())
+		{
+			// disabled again before the worker finished: PollStartup shuts the
+			// runtime back down when it does (only viewer shutdown waits for it)
+			if (!is_shutdown)
+				return;
+			runtime = m_fStartup.get().runtime;
+		}
+		gVrModOverlay.destroy();
+		gVrModCapture.stop();
+		gVrModHitch.stop();
+		if (runtime)
+			runtime->shutdown();
+		m_pRuntime = NULL;
 		gHMD = NULL;
 		gVRInitComplete = FALSE;
 		//m_tTimer1.stop();
@@ -738,6 +703,100 @@ void llviewerVR::vrStartup(bool is_shutdown)
 	
 }
 
+llviewerVR::StartupResult llviewerVR::vrStartupWorker(VrModRuntime *runtime)
+{
+	StartupResult result;
+	F64 start = LLTimer::getTotalSeconds();
+
+	VrModRuntime::Info info;
+	if (runtime->init(info, result.error, m_iStartupStage))
+	{
+		result.runtime = runtime;
+		result.hmd = info.hmd;
+		result.renderModels = info.renderModels;
+		result.driver = info.driver;
+		result.display = info.display;
+		result.width = info.width;
+		result.height = info.height;
+	}
+	m_iStartupStage = STARTUP_FINISHING;
+	result.seconds = LLTimer::getTotalSeconds() - start;
+	return result;
+}
+
+void llviewerVR::PollStartup()
+{
+	if (!m_fStartup.valid())
+		return;
+
+	if (m_fStartup.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+	{
+		static const char *stages[] = { "loading runtime", "acquiring interfaces", "querying device", "finishing" };
+		std::string progress = llformat("Initializing VR driver... (%s)", stages[llclamp((S32)m_iStartupStage, 0, 3)]);
+		if (hud_textp && progress != m_strHudText)
+		{
+			m_strHudText = progress;
+			hud_textp->setString(m_strHudText);
+			hud_textp->setDoFade(FALSE);
+			hud_textp->setHidden(FALSE);
+		}
+		return;
+	}
+
+	gVrModTelemetry.finishBegin();
+	StartupResult result = m_fStartup.get();
+	if (!m_bVrEnabled)
+	{
+		if (result.runtime)
+			result.runtime->shutdown();
+		gVrModTelemetry.startupEnd(FALSE, result.seconds);
+		return;
+	}
+
+	// what needs the GL context is set up here
+	if (result.runtime && !result.runtime->start(result.error))
+	{
+		result.runtime->shutdown();
+		result.runtime = NULL;
+	}
+
+	m_strHudText = "Initializing VR driver!";
+	m_strHudText.append(result.error);
+	if (result.runtime != NULL)
+	{
+		LL_WARNS() << "VRMOD: using the " << result.runtime->name() << " runtime" << LL_ENDL;
+		m_pRuntime = result.runtime;
+		gHMD = result.hmd;
+		gRenderModels = result.renderModels;
+		m_strDriver = result.driver;
+		m_strDisplay = result.display;
+		m_strHudText.append("\nDriver = ");
+		m_strHudText.append(m_strDriver);
+		m_strHudText.append("\nDisplay = ");
+		m_strHudText.append(m_strDisplay);
+		m_strHudText.append("\nVR driver! Initialized");
+
+		gVRInitComplete = TRUE;
+		m_nRenderWidth = result.width;
+		m_nRenderHeight = result.height;
+		CreateFrameBuffer(m_nRenderWidth, m_nRenderHeight, leftEyeDesc);
+		CreateFrameBuffer(m_nRenderWidth, m_nRenderHeight, rightEyeDesc);
+		SetupCameras();
+		F32 tanLeft, tanRight, tanDown, tanUp;
+		m_pRuntime->projectionRaw(vr::Eye_Left, &tanLeft, &tanRight, &tanDown, &tanUp);
+		gVrModTelemetry.stereoGeometry(eyeDistance() / 1000.f, m_nRenderWidth / llmax(tanRight - tanLeft, 0.01f));
+		//vr::VRCompositor()->ForceInterleavedReprojectionOn(true);
+		m_strHudText.append("\nCreating frame buffers.");
+	}
+	if(gVRInitComplete)
+		m_strHudText.append("\nVR driver ready.\n Press TAB to enter VR mode.");
+	hud_textp->setString(m_strHudText);
+	m_strHudText = "";
+	hud_textp->setDoFade(FALSE);
+	hud_textp->setHidden(FALSE);
+	gVrModTelemetry.startupEnd(gVRInitComplete, result.seconds);
+}
+
 bool llviewerVR::ProcessVRCamera()
 {
 	
@@ -769,7 +828,7 @@ bool llviewerVR::ProcessVRCamera()
 	}
 		
 	
-	if (gHMD == NULL)
+	if (m_pRuntime == NULL)
 	{
 		return FALSE;
 	}
@@ -816,7 +875,7 @@ bool llviewerVR::ProcessVRCamera()
 			LLViewerCamera::getInstance()->readFrustumFromBuffer(reinterpret_cast<const char*>(&frustumProxy));
 		}
 
-		if (!leftEyeDesc.IsReady && !rightEyeDesc.IsReady)//Starting rendering with first (left) eye of stereo rendering
+		if (!leftEyeDesc.IsReady && !rightEyeDesc.IsReady && !gVrModFarField.eyePass())//Starting rendering with first (left) eye of stereo rendering, or the far field pass before it
 		{
 			
 			
@@ -831,6 +890,7 @@ bool llviewerVR::ProcessVRCamera()
 			LLWindow * WI;
 			WI = gViewerWindow->getWindow();
 			WI->getCursorPosition(&m_MousePos);
+			gVrModPointer.applyToCursor(m_MousePos);
 			
 			LLCoordWindow m_ScrSize;
 			LLCoordWindow m_ScrSizeOld;
@@ -937,6 +997,7 @@ bool llviewerVR::ProcessVRCamera()
 			else
 				hud_textp->setHidden(TRUE);
 
+			gVrModFarField.beginFrame(eyeDistance() > 0);
 		}
 		
 
@@ -959,7 +1020,11 @@ bool llviewerVR::ProcessVRCamera()
 		{	
 			LLVector3 new_fwd_pos = m_vpos + (m_vdir * m_fFocusDistance);
 			
-			if (!leftEyeDesc.IsReady)//change pos for rendering the left eye texture.Move half IPD distance to the left
+			if (gVrModFarField.farPass())//the far field is rendered once, from between the eyes
+			{
+				LLViewerCamera::getInstance()->updateCameraLocation(m_vpos, m_vup, new_fwd_pos);
+			}
+			else if (!leftEyeDesc.IsReady)//change pos for rendering the left eye texture.Move half IPD distance to the left
 			{
 				LLViewerCamera::getInstance()->updateCameraLocation(m_vpos + new_dir, m_vup, new_fwd_pos);
 			}
@@ -977,11 +1042,15 @@ bool llviewerVR::ProcessVRCamera()
 
 void llviewerVR::vrDisplay()
 {
-	if (gHMD != NULL)
+	if (m_pRuntime != NULL)
 	{
 		if (m_bVrActive)//gAgentCamera.getCameraMode() == CAMERA_MODE_MOUSELOOK)
 		{
-			
+			if (gVrModFarField.farPass())//nothing to blit: the eye passes composite the far field (goto sec, see FarFieldRendered)
+			{
+				gVrModFarField.farDone();
+				return;
+			}
 
 			if (!leftEyeDesc.IsReady)
 			{
@@ -1037,8 +1106,8 @@ void llviewerVR::vrDisplay()
 					m_iZoomIndex = 0;
 				}
 
-				///Zoom in
-				if (m_iZoomIndex == 0 || !gVrModSettings->mousezoom)
+				///Zoom in (not needed when the UI is an overlay panel)
+				if (m_iZoomIndex == 0 || !gVrModSettings->mousezoom || gVrModOverlay.active())
 				{
 					bx +=   m_fTextureZoom;
 					by +=   m_fTextureZoom;
@@ -1148,17 +1217,21 @@ void llviewerVR::vrDisplay()
 				//if you do not call that anywhere no image will be processed. 
 				
 				
-				//submit the textures to the HMD
-				lEyeTexture = { (void*)(uintptr_t)leftEyeDesc.m_nResolveTextureId, vr::TextureType_OpenGL, vr::ColorSpace_Gamma };
-				eError = vr::VRCompositor()->Submit(vr::Eye_Left, &lEyeTexture, 0, (vr::EVRSubmitFlags)(vr::Submit_Default ));
+				gVrModFarField.eyesDone();
+				gVrModHitch.lap(VrModHitch::STAGE_RENDER);
+				gVrModCapture.frameSubmitted(leftEyeDesc.mFBO, eyeDistance() > 0 ? rightEyeDesc.mFBO : 0, m_nRenderWidth, m_nRenderHeight);
+				gVrModHitch.lap(VrModHitch::STAGE_CAPTURE);
 
-				rEyeTexture = { (void*)(uintptr_t)rightEyeDesc.m_nResolveTextureId, vr::TextureType_OpenGL, vr::ColorSpace_Gamma };
-				eError = vr::VRCompositor()->Submit(vr::Eye_Right, &rEyeTexture, 0, (vr::EVRSubmitFlags)(vr::Submit_Default));
+				//submit the textures to the HMD
+				m_pRuntime->submit(leftEyeDesc.m_nResolveTextureId, rightEyeDesc.m_nResolveTextureId);
+				gVrModTelemetry.frameSubmitted();
+				gVrModHitch.lap(VrModHitch::STAGE_SUBMIT);
 
 				//vr::VRCompositor()->PostPresentHandoff();// Here we tell the HMD  that rendering is done and it can render the image in to the HMD
 				//glFinish();
 				
 				gViewerWindow->getWindow()->swapBuffers();
+				gVrModHitch.lap(VrModHitch::STAGE_SWAP);
 				
 				
 				//glFlush();
@@ -1166,6 +1239,10 @@ void llviewerVR::vrDisplay()
 				
 				
 				UpdateHMDMatrixPose();
+				gVrModHitch.lap(VrModHitch::STAGE_WAIT);
+				gVrModOverlay.pollEvents();
+				gVrModPointer.dispatch();
+				gVrModHitch.frameEnd(m_pRuntime, gTrackedDevicePose);
 				//
 
 			}
@@ -1208,7 +1285,9 @@ void llviewerVR::ProcessVREvent(const vr::VREvent_t & event)//process vr´events
 		m_bVrActive = FALSE;
 		m_bVrEnabled = FALSE;
 		gHMD = NULL;
-		vr::VR_Shutdown();
+		if (m_pRuntime)
+			m_pRuntime->shutdown();
+		m_pRuntime = NULL;
 		vr::VRSystem()->AcknowledgeQuit_Exiting();
 	}
 	break;
@@ -1241,16 +1320,12 @@ void llviewerVR::agentYaw(F32 yaw_inc)  // move avatar forward backward and rota
 bool llviewerVR::HandleInput()// handles controller input for now  only the stick.
 {
 
-	if (gHMD == NULL || !m_bVrActive)
+	if (m_pRuntime == NULL || !m_bVrActive)
 		return FALSE;
 	bool bRet = false;
 
 	// Process SteamVR events
-	vr::VREvent_t event;
-	while (gHMD->PollNextEvent(&event, sizeof(event)))
-	{
-		ProcessVREvent(event);
-	}
+	m_pRuntime->pollEvents([this](vr::VREvent_t const& event) { ProcessVREvent(event); });
 
 	// Process SteamVR controller state
 	/*for (vr::TrackedDeviceIndex_t unDevice = 0; unDevice < vr::k_unMaxTrackedDeviceCount; unDevice++)
@@ -1388,12 +1463,27 @@ void llviewerVR::HandleKeyboard()
 			}
 				
 		}
-		else if (gHMD)
+		else if (m_pRuntime)
 		{
 			if (!m_bVrActive)
+			{
 				m_bVrActive = TRUE;
+				gVrModTelemetry.activated();
+				gVrModHitch.activated(m_pRuntime->displayFrequency());
+			}
 			else
+			{
 				m_bVrActive = FALSE;
+				gVrModPointer.reset();
+				gVrModTelemetry.deactivated();
+				gVrModHitch.deactivated();
+				gVrModUiLayer.release();
+				gVrModFarField.release();
+				gVrModPasses.release();
+				gVrModPoseTrace.stop();
+				gVrModCapture.stop();
+				gVrModOverlay.hide();
+			}
 			//LLViewerCamera::getInstance()->setDefaultFOV(1.8);
 			gHmdOffsetPos.mV[2] = 0;
 			// if (m_fFOV > 20)
@@ -1425,7 +1515,7 @@ void llviewerVR::HandleKeyboard()
 		
 	}
 
-	if (gHMD == NULL)
+	if (m_pRuntime == NULL)
 		return;
 	if (gKeyboard->getKeyDown(m_kEditKey) && !m_bEditKeyDown)
 	{
@@ -1463,9 +1553,69 @@ void llviewerVR::HandleKeyboard()
 
 }
 
+void llviewerVR::UpdateCull(LLCullResult& result, std::function<void()> const& update_cull)
+{
+	if (!m_bVrActive || !m_pRuntime)
+	{
+		update_cull();
+		return;
+	}
+	gVrModFarField.clipEyes(*LLViewerCamera::getInstance());
+	// eyes sit eyeDistance() / 1000 either side of m_vpos (ProcessVRCamera);
+	// the far field pass is one centre view, culled on its own
+	gVrModCull.cull(result, update_cull, !leftEyeDesc.IsReady, eyeDistance() > 0 && !gVrModFarField.farPass(), m_vpos, eyeDistance() / 1000.f, m_fFocusDistance);
+}
+
+void llviewerVR::StateSort(std::function<void()> const& state_sort)
+{
+	if (!m_bVrActive || !m_pRuntime)
+	{
+		state_sort();
+		return;
+	}
+	gVrModCull.stateSort(state_sort, !leftEyeDesc.IsReady);
+}
+
+void llviewerVR::RenderPass(S32 pass, std::function<void()> const& render)
+{
+	if (!m_bVrActive || !m_pRuntime)
+	{
+		render();
+		return;
+	}
+	// the far field pass renders its own, for its depth range
+	gVrModPasses.run((VrModPasses::Pass)pass, render, !leftEyeDesc.IsReady, eyeDistance() > 0 && !gVrModFarField.farPass());
+}
+
+void llviewerVR::RenderUI2D(std::function<void()> const& draw)
+{
+	if (!m_bVrActive || !m_pRuntime)
+	{
+		draw();
+		return;
+	}
+	// the far field pass draws no UI; its image is composited under the eyes' world
+	if (gVrModFarField.farPass())
+		return;
+	// the left eye pass (or the only one, with zero eye distance) starts the HMD frame
+	gVrModUiLayer.render(draw, !leftEyeDesc.IsReady);
+}
+
+void llviewerVR::RenderFinalize(std::function<void()> const& finalize)
+{
+	finalize();
+	if (m_bVrActive && m_pRuntime)
+		gVrModFarField.finalized();
+}
+
+bool llviewerVR::FarFieldRendered()
+{
+	return m_bVrActive && m_pRuntime && gVrModFarField.eyePass() && !leftEyeDesc.IsReady;
+}
+
 void llviewerVR::DrawCursors()
 {
-	if (!m_bVrActive || (!gVrModSettings->handlasers && !gVrModSettings->mousecursor))
+	if (!m_bVrActive || gVrModFarField.farPass() || (!gVrModSettings->handlasers && !gVrModSettings->mousecursor))
 		return;
 	gUIProgram.bind();
 	//glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
@@ -1499,7 +1649,7 @@ void llviewerVR::DrawCursors()
 
 	}
 
-	if (gVrModSettings->mousecursor)
+	if (gVrModSettings->mousecursor && !gVrModOverlay.active())
 	if (gAgentCamera.getCameraMode() != CAMERA_MODE_MOUSELOOK)
 	{
 		LLColor4 cl;
@@ -1531,25 +1681,37 @@ void llviewerVR::RenderControllerAxes()
 	//gCtrlNum = 0;
 	
 	HandleKeyboard();
+	PollStartup();
 	
-	if (gHMD == NULL)
+	if (m_pRuntime == NULL)
 		return;
 	HandleInput();
-	if (!gHMD->IsInputAvailable() || !m_bVrActive || !gVrModSettings->handcontrollers)
+	if (m_pRuntime == NULL || !m_pRuntime->inputAvailable() || !m_bVrActive || !gVrModSettings->handcontrollers || gVrModFarField.farPass())
 		return;
 
+	if (gVrModSettings->projectionCheck)
+	{
+		gSavedSettings.setBOOL("vrmod.projectionCheck", FALSE);
+		gVrModProjection.selfCheck();
+	}
+
 	//std::vector<float> vertdataarray;
 	//m_uiControllerVertcount = 0;
 	//m_iTrackedControllerCount = 0;
 	
+	// controllers with a valid pose and the far end of their ray
+	vr::TrackedDeviceIndex_t rayDevices[vr::k_unMaxTrackedDeviceCount];
+	LLVector3 rayEnds[vr::k_unMaxTrackedDeviceCount];
+	LLCoordGL rayScreen[vr::k_unMaxTrackedDeviceCount];
+	U32 rayCount = 0;
 	
 	for (vr::TrackedDeviceIndex_t unTrackedDevice = vr::k_unTrackedDeviceIndex_Hmd + 1; unTrackedDevice < vr::k_unMaxTrackedDeviceCount; ++unTrackedDevice)
 	{
 		gCtrlscreen[unTrackedDevice].set(-1, -1);
-		if (!gHMD->IsTrackedDeviceConnected(unTrackedDevice))
+		if (!m_pRuntime->deviceConnected(unTrackedDevice))
 			continue;
 
-		if (gHMD->GetTrackedDeviceClass(unTrackedDevice) != vr::TrackedDeviceClass_Controller)
+		if (m_pRuntime->deviceClass(unTrackedDevice) != vr::TrackedDeviceClass_Controller)
 			continue;
 
 		m_iTrackedControllerCount += 1;
@@ -1620,8 +1782,18 @@ void llviewerVR::RenderControllerAxes()
 		//project 10 meter line  in the direction the controller is facing
 		gCtrlPos[unTrackedDevice] = gCtrlOrigin[unTrackedDevice]  - (dir * 10.0f);
 
-		//translate the fwd vector line to screen coords
-		posToScreen(gCtrlPos[unTrackedDevice], gCtrlscreen[unTrackedDevice], FALSE);
+		rayDevices[rayCount] = unTrackedDevice;
+		rayEnds[rayCount++] = gCtrlPos[unTrackedDevice];
+	}
+
+	//translate the fwd vector lines to screen coords, all controllers in one pass
+	gVrModProjection.update();
+	gVrModProjection.project(rayEnds, rayScreen, rayCount);
+
+	for (U32 nRay = 0; nRay < rayCount; ++nRay)
+	{
+		vr::TrackedDeviceIndex_t unTrackedDevice = rayDevices[nRay];
+		gCtrlscreen[unTrackedDevice] = rayScreen[nRay];
 	
 		//adjust the pos so it fits with the actual mouse cursor pos
 		S32 height = gViewerWindow->getWorldViewHeightScaled();
@@ -1653,19 +1825,17 @@ void llviewerVR::RenderControllerAxes()
 		}
 
 		if (gVrModSettings->handcontrollers) {
-		//EVRControllerAxisType
-		//read the input from the available controllers
-		vr::VRControllerState_t state;
-		if (gHMD->GetControllerState(unTrackedDevice, &state, sizeof(state)))
+		//read the input from the available controllers (SteamVR Input, see llviewerVR.vrmod_runtime.c++)
+		VrModInput::ControllerActions actions;
+		if (m_pRuntime->controllerActions(unTrackedDevice, actions))
 		{
-			m_rbShowTrackedDevice[unTrackedDevice] = state.ulButtonPressed == 0;
-			if (1)// state.unPacketNum != gPacketNum)
+			m_rbShowTrackedDevice[unTrackedDevice] = !actions.click && !actions.context;
+			if (1)
 			{
 				//if(LLFloaterCamera::inFreeCameraMode())
-				gPacketNum = state.unPacketNum;
 				//Get the joystick hat state of the controller and move the avatar.. (Figure out how to map it tpo vive and oculus)
 				//add movement intensity slider here.
-				if (fabs(state.rAxis[2].x) > 0.5 && gHMD->GetControllerRoleForTrackedDeviceIndex(unTrackedDevice))// +x rechts +y fwd
+				if (fabs(actions.move.mV[VX]) > 0.5)// +x rechts +y fwd
 				{
 					if (LLFloaterCamera::inFreeCameraMode())
 					{
@@ -1677,12 +1847,12 @@ void llviewerVR::RenderControllerAxes()
 					else
 					{
 						m_fCamRotOffset = 90;
-						agentYaw(state.rAxis[2].x / 40);
+						agentYaw(actions.move.mV[VX] / 40);
 
 					}
 							
 				}
-				else if (state.rAxis[2].y > 0.5)// +y forward
+				else if (actions.move.mV[VY] > 0.5)// +y forward
 				{
 					if (LLFloaterCamera::inFreeCameraMode())
 					{
@@ -1697,7 +1867,7 @@ void llviewerVR::RenderControllerAxes()
 						
 				}
 					
-				else if (state.rAxis[2].y < -0.5)// -y back
+				else if (actions.move.mV[VY] < -0.5)// -y back
 				{
 					if (LLFloaterCamera::inFreeCameraMode())
 					{
@@ -1714,9 +1884,8 @@ void llviewerVR::RenderControllerAxes()
 					
 				
 				
-				gButton = state.ulButtonPressed;
-				LLWindow * WI;
-				WI = gViewerWindow->getWindow();
+				gButton = (actions.click ? vr::ButtonMaskFromId(vr::k_EButton_SteamVR_Trigger) : 0)
+					| (actions.context ? vr::ButtonMaskFromId(vr::k_EButton_Grip) : 0);
 				//MASK mask = gKeyboard->currentMask(TRUE);
 				
 
@@ -1733,84 +1902,36 @@ void llviewerVR::RenderControllerAxes()
 				//WI->getCursorPosition(mcpos);
 
 				//Emulate mouse clicks with the controllers trigger and grip buttons
+				//(queued here, delivered to gViewerWindow at the end of the frame)
+				bool mouselook = gAgentCamera.getCameraMode() == CAMERA_MODE_MOUSELOOK;
 
-				if ((state.ulButtonPressed &  vr::ButtonMaskFromId(vr::k_EButton_Grip)) && !gRightClick[unTrackedDevice])
+				if (actions.context && !gRightClick[unTrackedDevice])
 				{
-
 					gRightClick[unTrackedDevice] = TRUE;
-					if (gAgentCamera.getCameraMode() != CAMERA_MODE_MOUSELOOK)
-					{
-
-						WI->setCursorPosition(cpos);
-					}
-
-					//LLWindowWin32 *window_imp = (LLWindowWin32 *)GetWindowLongPtr(mAppWindowHandle, GWLP_USERDATA);
-
-					//gViewerWindow->handleAnyMouseClick(WI, gCtrlscreen[unTrackedDevice], mask, LLMouseHandler::CLICK_RIGHT, TRUE);
-
-
-#ifdef _WIN32
-					INPUT Inputs[1] { 0 };
-					Inputs[0].type = INPUT_MOUSE;
-					Inputs[0].mi.dwFlags = MOUSEEVENTF_RIGHTDOWN;
-					SendInput(1, Inputs, sizeof(INPUT));
-#else
-#endif
+					gVrModPointer.push(VrModPointer::RIGHT_DOWN, cpos, mouselook);
 				}
-				else if (gRightClick[unTrackedDevice] && !(state.ulButtonPressed &  vr::ButtonMaskFromId(vr::k_EButton_Grip)))
+				else if (gRightClick[unTrackedDevice] && !actions.context)
 				{
 					gRightClick[unTrackedDevice] = FALSE;
-
-					//gViewerWindow->handleAnyMouseClick(WI, gCtrlscreen[unTrackedDevice], mask, LLMouseHandler::CLICK_RIGHT, FALSE);
-#ifdef _WIN32
-					INPUT Inputs[1] = { 0 };
-					Inputs[0].type = INPUT_MOUSE;
-					Inputs[0].mi.dwFlags = MOUSEEVENTF_RIGHTUP;
-					SendInput(1, Inputs, sizeof(INPUT));
-#else
-#endif
+					gVrModPointer.push(VrModPointer::RIGHT_UP, cpos, TRUE);
 				}
 
 
-				if ((state.ulButtonPressed & vr::ButtonMaskFromId(vr::k_EButton_SteamVR_Trigger)) && !gLeftClick[unTrackedDevice])
+				if (actions.click && !gLeftClick[unTrackedDevice])
 				{
 					gLeftClick[unTrackedDevice] = TRUE;
-					if (gAgentCamera.getCameraMode() != CAMERA_MODE_MOUSELOOK)
-					{
-						
-						//LLWindow * WI;
-						//WI = gViewerWindow->getWindow();
-						//S32 width = gViewerWindow->getWorldViewWidthScaled();
-						//S32 height = gViewerWindow->getWorldViewHeightScaled();
-						//LLCoordWindow size;
-						//size.mX = gCtrlscreen[0].mX;
-						//size.mY = height - gCtrlscreen[0].mY;
-						WI->setCursorPosition(cpos);
-					}
-#ifdef _WIN32
-					INPUT Inputs[1] = { 0 };
-					Inputs[0].type = INPUT_MOUSE;
-					Inputs[0].mi.dwFlags = MOUSEEVENTF_LEFTDOWN;
-					SendInput(1, Inputs, sizeof(INPUT));
-#else
-#endif
+					gVrModPointer.push(VrModPointer::LEFT_DOWN, cpos, mouselook);
 				}
-				else if (gLeftClick[unTrackedDevice] && !(state.ulButtonPressed & vr::ButtonMaskFromId(vr::k_EButton_SteamVR_Trigger)))
+				else if (gLeftClick[unTrackedDevice] && !actions.click)
 				{
 					gLeftClick[unTrackedDevice] = FALSE;
-#ifdef _WIN32
-					INPUT Inputs[1] = { 0 };
-					Inputs[0].type = INPUT_MOUSE;
-					Inputs[0].mi.dwFlags = MOUSEEVENTF_LEFTUP;
-					SendInput(1, Inputs, sizeof(INPUT));
-#else
-#endif
+					gVrModPointer.push(VrModPointer::LEFT_UP, cpos, TRUE);
 				}
 
-				if(gAgentCamera.getCameraMode() != CAMERA_MODE_MOUSELOOK && gLeftClick[unTrackedDevice] && cpos.mX>-1 && cpos.mX < width  && cpos.mY >-1 && cpos.mY < height)
+				//drag while the trigger is held
+				if(!mouselook && gLeftClick[unTrackedDevice] && cpos.mX>-1 && cpos.mX < width  && cpos.mY >-1 && cpos.mY < height)
 				{
-					
-					WI->setCursorPosition(cpos);
+					gVrModPointer.push(VrModPointer::MOVE, cpos);
 				}
 
 			}
@@ -1820,130 +1941,6 @@ void llviewerVR::RenderControllerAxes()
 	
 }
 
-BOOL llviewerVR::posToScreen(const LLVector3 &pos_agent, LLCoordGL &out_point, const BOOL clamp) const
-{
-	//BOOL in_front = TRUE;
-	GLdouble	x, y, z;			// object's window coords, GL-style
-
-	/*LLVector3 dir_to_point = pos_agent - LLViewerCamera::getInstance()->getOrigin();
-	dir_to_point /= dir_to_point.magVec();
-
-	if (dir_to_point * LLCoordFrame::getAtAxis() < 0.f)
-	{
-		if (clamp)
-		{
-			return FALSE;
-		}
-		else
-		{
-			in_front = FALSE;
-		}
-	}
-	*/
-	LLRect world_view_rect = gViewerWindow->getWorldViewRectRaw();
-	
-	//LLRect world_view_rect = gViewerWindow->handleAnyMouseClick;
-	
-	S32	viewport[4];
-	viewport[0] = world_view_rect.mLeft;
-	viewport[1] = world_view_rect.mBottom;
-	viewport[2] = world_view_rect.getWidth();
-	viewport[3] = world_view_rect.getHeight();
-
-	F64 mdlv[16];
-	F64 proj[16];
-
-	for (U32 i = 0; i < 16; i++)
-	{
-		mdlv[i] = (F64)gGLModelView[i];
-		proj[i] = (F64)gGLProjection[i];
-	}
-
-	if (GL_TRUE == gluProject(pos_agent.mV[VX], pos_agent.mV[VY], pos_agent.mV[VZ],
-		mdlv, proj, (GLint*)viewport,
-		&x, &y, &z))
-	{
-		// convert screen coordinates to virtual UI coordinates
-		x /= gViewerWindow->getDisplayScale().mV[VX];
-		y /= gViewerWindow->getDisplayScale().mV[VY];
-
-		// should now have the x,y coords of grab_point in screen space
-		LLRect world_rect = gViewerWindow->getWorldViewRectScaled();
-
-		// convert to pixel coordinates
-		S32 int_x = lltrunc(x);
-		S32 int_y = lltrunc(y);
-
-		out_point.mX = int_x;
-		out_point.mY = int_y;
-
-		BOOL valid = TRUE;
-		return valid;
-		/*
-		if (clamp)
-		{
-			if (int_x < world_rect.mLeft)
-			{
-				out_point.mX = world_rect.mLeft;
-				valid = FALSE;
-			}
-			else if (int_x > world_rect.mRight)
-			{
-				out_point.mX = world_rect.mRight;
-				valid = FALSE;
-			}
-			else
-			{
-				out_point.mX = int_x;
-			}
-
-			if (int_y < world_rect.mBottom)
-			{
-				out_point.mY = world_rect.mBottom;
-				valid = FALSE;
-			}
-			else if (int_y > world_rect.mTop)
-			{
-				out_point.mY = world_rect.mTop;
-				valid = FALSE;
-			}
-			else
-			{
-				out_point.mY = int_y;
-			}
-			return valid;
-		}
-		else
-		{
-			out_point.mX = int_x;
-			out_point.mY = int_y;
-
-			if (int_x < world_rect.mLeft)
-			{
-				valid = FALSE;
-			}
-			else if (int_x > world_rect.mRight)
-			{
-				valid = FALSE;
-			}
-			if (int_y < world_rect.mBottom)
-			{
-				valid = FALSE;
-			}
-			else if (int_y > world_rect.mTop)
-			{
-				valid = FALSE;
-			}
-
-			return in_front && valid;
-		}*/
-	}
-	else
-	{
-		return FALSE;
-	}
-}
-
 void  llviewerVR::buttonCallbackLeft()
 {
 	if (m_pCamStack)
@@ -2004,12 +2001,12 @@ void llviewerVR::Debug()
 	F32 leftVrTanAngleRight = 0.0;
 	F32 leftVrTanAngleUp = 0.0;
 	F32 leftVrTanAngleDown = 0.0;
-	gHMD->GetProjectionRaw(vr::Eye_Left, &leftVrTanAngleLeft, &leftVrTanAngleRight, &leftVrTanAngleDown, &leftVrTanAngleUp); // Valve documentation backwards?
+	m_pRuntime->projectionRaw(vr::Eye_Left, &leftVrTanAngleLeft, &leftVrTanAngleRight, &leftVrTanAngleDown, &leftVrTanAngleUp); // Valve documentation backwards?
 	F32 rightVrTanAngleLeft = 0.0;
 	F32 rightVrTanAngleRight = 0.0;
 	F32 rightVrTanAngleUp = 0.0;
 	F32 rightVrTanAngleDown = 0.0;
-	gHMD->GetProjectionRaw(vr::Eye_Right, &rightVrTanAngleLeft, &rightVrTanAngleRight, &rightVrTanAngleDown, &rightVrTanAngleUp); // Valve documentation backwards?
+	m_pRuntime->projectionRaw(vr::Eye_Right, &rightVrTanAngleLeft, &rightVrTanAngleRight, &rightVrTanAngleDown, &rightVrTanAngleUp); // Valve documentation backwards?
 
 
 	calcUVBounds(vr::Eye_Left, &uMinLeft, &uMaxLeft, &vMinLeft, &vMaxLeft);
@@ -7,6 +7,12 @@
 #include "string.h"
 #include "llfloater.h"
 #include "llfloatercamera.h"
+#include <atomic>
+#include <functional>
+#include <future>
+
+class LLCullResult;
+struct VrModRuntime;
 //#include "control.h"
 //#include "llviewercamera.h"
 //#include "llagentcamera.h"
@@ -18,6 +24,7 @@
 class llviewerVR
 {
 public:
+	VrModRuntime *m_pRuntime = 0; // the runtime VR mode runs on; NULL while off
 	vr::IVRSystem *gHMD = 0;
 	vr::IVRCompositor* gCompositor = 0;
 	vr::IVRRenderModels * gRenderModels = 0;
@@ -57,6 +64,31 @@ public:
 	bool isRenderingLeftEye = 0;
 	bool gVRInitComplete = 0;
 
+	// VR startup is split in two: runtime load, interface acquisition and
+	// device queries run on a worker (vrStartupWorker), the eye framebuffers
+	// are created on the render thread once it is done (PollStartup)
+	enum StartupStage
+	{
+		STARTUP_LOADING_RUNTIME,
+		STARTUP_ACQUIRING_INTERFACES,
+		STARTUP_QUERYING_DEVICE,
+		STARTUP_FINISHING
+	};
+	struct StartupResult
+	{
+		VrModRuntime *runtime = NULL;
+		vr::IVRSystem *hmd = NULL; // OpenVR only
+		vr::IVRRenderModels *renderModels = NULL;
+		std::string driver;
+		std::string display;
+		std::string error;
+		U32 width = 0;
+		U32 height = 0;
+		F64 seconds = 0;
+	};
+	std::future<StartupResult> m_fStartup;
+	std::atomic<S32> m_iStartupStage{ STARTUP_LOADING_RUNTIME };
+
 
 	S32 m_iTextureShift = 0;
 
@@ -194,15 +226,22 @@ public:
 	void SetupCameras();
 	bool CreateFrameBuffer(int nWidth, int nHeight, FramebufferDesc &framebufferDesc);
 	void vrStartup(bool is_shutdown);
+	StartupResult vrStartupWorker(VrModRuntime *runtime);
+	void PollStartup();
 	void vrDisplay();
 	bool HandleInput();
+	void UpdateCull(LLCullResult& result, std::function<void()> const& update_cull);
+	void StateSort(std::function<void()> const& state_sort);
+	void RenderPass(S32 pass, std::function<void()> const& render); // VrModPasses::Pass
+	void RenderUI2D(std::function<void()> const& draw);
+	void RenderFinalize(std::function<void()> const& finalize);
+	bool FarFieldRendered(); // far field pass done, the left eye pass follows
 	void DrawCursors();
 	void ProcessVREvent(const vr::VREvent_t & event);
 	void agentYaw(F32 yaw_inc);
 	bool ProcessVRCamera();
 	std::string GetTrackedDeviceString(vr::IVRSystem *pHmd, vr::TrackedDeviceIndex_t unDevice, vr::TrackedDeviceProperty prop, vr::TrackedPropertyError *peError = NULL);
 	void RenderControllerAxes();
-	BOOL posToScreen(const LLVector3 &pos_agent, LLCoordGL &out_point, const BOOL clamp) const;
 	void buttonCallbackLeft();
 	void buttonCallbackRight();
 	void HandleKeyboard();
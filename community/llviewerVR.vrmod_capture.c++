@@ -0,0 +1,469 @@
+/*
+================================================================================
+VR MOD CAPTURE: asynchronous readback of the submitted eye textures (humbletim 2026)
+================================================================================
+
+What the headset was shown could only be seen in the headset. With
+`vrmod.capture`, every `vrmod.captureEvery`-th submitted eye pair is copied
+back and written to `logs/vrmod_capture/` without stalling the frame:
+
+-   as the pair is submitted, each eye framebuffer is read into one of a
+    small ring of pixel buffer objects (`glReadPixels` into a
+    `GL_PIXEL_PACK_BUFFER` returns immediately) and a fence is inserted,
+-   on later frames, slots whose fence has signalled are mapped and their
+    pixels handed to a writer thread; a capture that finds its ring slot
+    still in flight is dropped rather than waited for,
+-   the writer thread flips the rows, encodes (`vrmod.captureFormat`:
+    `qoi`, `png` or `raw` RGBA) and writes `frameNNNNNN_L|R.<ext>`.
+
+Frames are numbered from when capture was switched on, so together with a
+replayed pose trace (VR MOD POSE TRACE) the same numbers show the same
+motion from run to run. If `logs/vrmod_capture/reference/` holds a file of
+the same name, the capture is compared against it: both are reduced to
+luma, blurred over 3x3 pixels to ignore anti-aliasing noise, and the share
+of pixels differing by more than a just-noticeable step is logged with the
+PSNR as `VRMOD: capture diff`. A regression run is then: replay the trace
+with capture on, and search the log for differences above zero.
+
+Writes, drops and diffs are summarized as `VRMOD: capture` when VR mode is
+left.
+
+*/
+
+#include "llimagepng.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+struct VrModCapture {
+    static const U32 SLOTS = 4;        // two eye pairs in flight
+    static const U32 MAX_QUEUED = 8;   // images waiting for the writer
+
+    struct Slot {
+        GLuint pbo = 0;
+        GLsync fence = 0;
+        U32 frame = 0;
+        char eye = 'L';
+        S32 width = 0, height = 0;
+    };
+
+    struct Image {
+        U32 frame;
+        char eye;
+        S32 width, height;
+        std::vector<U8> pixels;  // RGBA, bottom-up as read
+    };
+
+    Slot mSlots[SLOTS];
+    U32 mNextSlot = 0;
+    bool mActive = false;
+    U32 mFrame = 0;       // submitted eye pairs since capture was switched on
+    F64 mNextCaptureAt = 0.0;
+    std::string mFormat;  // vrmod.captureFormat when capture was switched on
+
+    std::thread mWriter;
+    std::mutex mMutex;
+    std::condition_variable mWake;
+    std::deque<Image> mQueue;
+    bool mStopping = false;
+
+    // written by the writer thread
+    std::atomic<U32> mWritten{ 0 };
+    std::atomic<U32> mDiffed{ 0 };
+    std::atomic<U32> mDiffering{ 0 };
+    U32 mDropped = 0;
+
+    // as both eyes are submitted: collects finished readbacks, starts new
+    // ones (right_fbo is 0 when only one eye was rendered)
+    void frameSubmitted(GLuint left_fbo, GLuint right_fbo, S32 width, S32 height);
+
+    // VR mode left / shut down: finishes outstanding writes
+    void stop();
+
+private:
+    void start();
+    void collect(bool wait);
+    bool readback(GLuint fbo, U32 frame, char eye, S32 width, S32 height);
+    void enqueue(Image&& image);
+    void writerLoop();
+    void write(Image& image);
+};
+
+namespace {
+    std::string capture_dir() {
+        return gDirUtilp->getExpandedFilename(LL_PATH_LOGS, "vrmod_capture");
+    }
+
+    // QOI ("Quite OK Image"), RGBA: https://qoiformat.org/qoi-specification.pdf
+    struct QoiPixel { U8 r, g, b, a; };
+
+    inline U32 qoi_hash(QoiPixel const& p) {
+        return (p.r * 3 + p.g * 5 + p.b * 7 + p.a * 11) % 64;
+    }
+
+    inline bool operator==(QoiPixel const& a, QoiPixel const& b) {
+        return a.r == b.r && a.g == b.g && a.b == b.b && a.a == b.a;
+    }
+
+    void put_u32_be(std::vector<U8>& out, U32 v) {
+        out.push_back((U8)(v >> 24)); out.push_back((U8)(v >> 16)); out.push_back((U8)(v >> 8)); out.push_back((U8)v);
+    }
+
+    std::vector<U8> qoi_encode(const U8* rgba, U32 width, U32 height) {
+        std::vector<U8> out;
+        out.reserve(14 + width * height + 8);
+        out.insert(out.end(), { 'q', 'o', 'i', 'f' });
+        put_u32_be(out, width);
+        put_u32_be(out, height);
+        out.push_back(4); // channels
+        out.push_back(0); // sRGB with linear alpha
+
+        QoiPixel index[64] = {};
+        QoiPixel prev = { 0, 0, 0, 255 };
+        U32 run = 0;
+        const size_t count = (size_t)width * height;
+        for (size_t i = 0; i < count; ++i) {
+            const QoiPixel px = { rgba[i * 4], rgba[i * 4 + 1], rgba[i * 4 + 2], rgba[i * 4 + 3] };
+            if (px == prev) {
+                if (++run == 62 || i + 1 == count) {
+                    out.push_back((U8)(0xc0 | (run - 1)));
+                    run = 0;
+                }
+                continue;
+            }
+            if (run) {
+                out.push_back((U8)(0xc0 | (run - 1)));
+                run = 0;
+            }
+            const U32 hash = qoi_hash(px);
+            if (index[hash] == px) {
+                out.push_back((U8)hash);
+            } else {
+                index[hash] = px;
+                if (px.a == prev.a) {
+                    const S32 vr = (S8)(px.r - prev.r), vg = (S8)(px.g - prev.g), vb = (S8)(px.b - prev.b);
+                    const S32 vg_r = vr - vg, vg_b = vb - vg;
+                    if (vr > -3 && vr < 2 && vg > -3 && vg < 2 && vb > -3 && vb < 2) {
+                        out.push_back((U8)(0x40 | (vr + 2) << 4 | (vg + 2) << 2 | (vb + 2)));
+                    } else if (vg_r > -9 && vg_r < 8 && vg > -33 && vg < 32 && vg_b > -9 && vg_b < 8) {
+                        out.push_back((U8)(0x80 | (vg + 32)));
+                        out.push_back((U8)((vg_r + 8) << 4 | (vg_b + 8)));
+                    } else {
+                        out.insert(out.end(), { 0xfe, px.r, px.g, px.b });
+                    }
+                } else {
+                    out.insert(out.end(), { 0xff, px.r, px.g, px.b, px.a });
+                }
+            }
+            prev = px;
+        }
+        out.insert(out.end(), { 0, 0, 0, 0, 0, 0, 0, 1 });
+        return out;
+    }
+
+    bool qoi_decode(std::vector<U8> const& in, std::vector<U8>& rgba, S32& width, S32& height) {
+        if (in.size() < 14 + 8 || memcmp(in.data(), "qoif", 4)) return false;
+        width = (S32)(in[4] << 24 | in[5] << 16 | in[6] << 8 | in[7]);
+        height = (S32)(in[8] << 24 | in[9] << 16 | in[10] << 8 | in[11]);
+        if (width <= 0 || height <= 0 || (U64)width * height > 100000000ull) return false;
+
+        const size_t count = (size_t)width * height;
+        rgba.resize(count * 4);
+        QoiPixel index[64] = {};
+        QoiPixel px = { 0, 0, 0, 255 };
+        size_t p = 14;
+        const size_t end = in.size() - 8;
+        U32 run = 0;
+        for (size_t i = 0; i < count; ++i) {
+            if (run) {
+                run--;
+            } else if (p < end) {
+                const U8 b1 = in[p++];
+                if (b1 == 0xfe) {
+                    px.r = in[p]; px.g = in[p + 1]; px.b = in[p + 2]; p += 3;
+                } else if (b1 == 0xff) {
+                    px.r = in[p]; px.g = in[p + 1]; px.b = in[p + 2]; px.a = in[p + 3]; p += 4;
+                } else if ((b1 & 0xc0) == 0x00) {
+                    px = index[b1];
+                } else if ((b1 & 0xc0) == 0x40) {
+                    px.r += ((b1 >> 4) & 0x03) - 2;
+                    px.g += ((b1 >> 2) & 0x03) - 2;
+                    px.b += (b1 & 0x03) - 2;
+                } else if ((b1 & 0xc0) == 0x80) {
+                    const U8 b2 = in[p++];
+                    const S32 vg = (b1 & 0x3f) - 32;
+                    px.r += vg - 8 + ((b2 >> 4) & 0x0f);
+                    px.g += vg;
+                    px.b += vg - 8 + (b2 & 0x0f);
+                } else {
+                    run = b1 & 0x3f;
+                }
+                index[qoi_hash(px)] = px;
+            }
+            rgba[i * 4] = px.r; rgba[i * 4 + 1] = px.g; rgba[i * 4 + 2] = px.b; rgba[i * 4 + 3] = px.a;
+        }
+        return true;
+    }
+
+    bool read_file(std::string const& path, std::vector<U8>& out) {
+        llifstream in(path, std::ios::binary);
+        if (!in.is_open()) return false;
+        out.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        return true;
+    }
+
+    bool load_reference(std::string const& path, std::string const& format, std::vector<U8>& rgba, S32& width, S32& height) {
+        if (!LLFile::isfile(path)) return false;
+        if (format == "png") {
+            LLPointer<LLImagePNG> png = new LLImagePNG;
+            LLPointer<LLImageRaw> raw = new LLImageRaw;
+            if (!png->load(path) || !png->decode(raw, 0.f) || raw->getComponents() < 3) return false;
+            width = raw->getWidth();
+            height = raw->getHeight();
+            const S32 components = raw->getComponents();
+            rgba.resize((size_t)width * height * 4);
+            for (size_t i = 0; i < (size_t)width * height; ++i) {
+                memcpy(&rgba[i * 4], raw->getData() + i * components, 3);
+                rgba[i * 4 + 3] = 255;
+            }
+            return true;
+        }
+        std::vector<U8> bytes;
+        if (!read_file(path, bytes)) return false;
+        if (format == "qoi") return qoi_decode(bytes, rgba, width, height);
+        rgba.swap(bytes); // raw: size is checked by the caller
+        return true;
+    }
+
+    // perceptual comparison of two top-down RGBA images of equal size: the
+    // share of pixels whose blurred luma differs by more than a
+    // just-noticeable step, and the PSNR over RGB
+    struct DiffResult {
+        F32 differingPercent;
+        F32 psnr;
+    };
+
+    DiffResult perceptual_diff(const U8* a, const U8* b, S32 width, S32 height) {
+        const F32 JND = 0.02f * 255.f;
+        std::vector<F32> luma_a((size_t)width * height), luma_b((size_t)width * height);
+        F64 squared_error = 0.0;
+        for (size_t i = 0; i < luma_a.size(); ++i) {
+            const U8* pa = a + i * 4;
+            const U8* pb = b + i * 4;
+            luma_a[i] = 0.299f * pa[0] + 0.587f * pa[1] + 0.114f * pa[2];
+            luma_b[i] = 0.299f * pb[0] + 0.587f * pb[1] + 0.114f * pb[2];
+            for (S32 c = 0; c < 3; ++c) {
+                const F64 d = (F64)pa[c] - pb[c];
+                squared_error += d * d;
+            }
+        }
+        U32 differing = 0;
+        for (S32 y = 0; y < height; ++y) {
+            for (S32 x = 0; x < width; ++x) {
+                F32 sum = 0.f;
+                S32 n = 0;
+                for (S32 dy = -1; dy <= 1; ++dy) {
+                    for (S32 dx = -1; dx <= 1; ++dx) {
+                        const S32 sx = x + dx, sy = y + dy;
+                        if (sx < 0 || sy < 0 || sx >= width || sy >= height) continue;
+                        const size_t j = (size_t)sy * width + sx;
+                        sum += luma_a[j] - luma_b[j];
+                        n++;
+                    }
+                }
+                if (fabsf(sum / n) > JND) differing++;
+            }
+        }
+        const F64 mse = squared_error / ((F64)width * height * 3);
+        return { 100.f * differing / ((F32)width * height),
+                 mse > 0.0 ? (F32)(10.0 * log10(255.0 * 255.0 / mse)) : INFINITY };
+    }
+} // namespace
+
+void VrModCapture::frameSubmitted(GLuint left_fbo, GLuint right_fbo, S32 width, S32 height) {
+    if (gVrModSettings->capture != mActive) {
+        if (mActive) stop(); else start();
+    }
+    if (!mActive) return;
+
+    collect(false);
+
+    const U32 frame = mFrame++;
+    if (frame < mNextCaptureAt) return;
+    mNextCaptureAt = frame + llmax((F32)gVrModSettings->captureEvery, 1.f);
+
+    if (!readback(left_fbo, frame, 'L', width, height)) mDropped++;
+    if (right_fbo && !readback(right_fbo, frame, 'R', width, height)) mDropped++;
+}
+
+void VrModCapture::start() {
+    LLFile::mkdir(capture_dir());
+    for (auto& slot : mSlots) glGenBuffers(1, &slot.pbo);
+    mNextSlot = 0;
+    mFrame = 0;
+    mNextCaptureAt = 0.0;
+    mWritten = mDiffed = mDiffering = 0;
+    mDropped = 0;
+    mFormat = gVrModSettings->captureFormat;
+    if (mFormat != "png" && mFormat != "raw") mFormat = "qoi";
+    mStopping = false;
+    mWriter = std::thread([this] { writerLoop(); });
+    mActive = true;
+    LL_WARNS() << "VRMOD: capturing eye textures to " << capture_dir() << LL_ENDL;
+}
+
+void VrModCapture::stop() {
+    if (!mActive) return;
+    collect(true);
+    for (auto& slot : mSlots) {
+        if (slot.fence) glDeleteSync(slot.fence);
+        glDeleteBuffers(1, &slot.pbo);
+        slot = Slot();
+    }
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStopping = true;
+    }
+    mWake.notify_all();
+    mWriter.join();
+    mActive = false;
+    LL_WARNS() << "VRMOD: capture " << mWritten << " images written, " << mDropped << " dropped; "
+               << mDiffed << " compared against references, " << mDiffering << " differing" << LL_ENDL;
+}
+
+bool VrModCapture::readback(GLuint fbo, U32 frame, char eye, S32 width, S32 height) {
+    Slot& slot = mSlots[mNextSlot];
+    mNextSlot = (mNextSlot + 1) % SLOTS;
+    if (slot.fence) return false; // still in flight
+
+    const GLsizeiptr size = (GLsizeiptr)width * height * 4;
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+    if (slot.width != width || slot.height != height) {
+        glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+    }
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    slot.frame = frame;
+    slot.eye = eye;
+    slot.width = width;
+    slot.height = height;
+    return true;
+}
+
+void VrModCapture::collect(bool wait) {
+    for (U32 i = 0; i < SLOTS; ++i) {
+        // oldest first, so images reach the writer in frame order
+        Slot& slot = mSlots[(mNextSlot + i) % SLOTS];
+        if (!slot.fence) continue;
+        const GLuint64 timeout = wait ? 1000000000ull : 0;
+        const GLenum status = glClientWaitSync(slot.fence, wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0, timeout);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) continue;
+        glDeleteSync(slot.fence);
+        slot.fence = 0;
+
+        Image image = { slot.frame, slot.eye, slot.width, slot.height, {} };
+        const size_t size = (size_t)slot.width * slot.height * 4;
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+        if (const void* mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT)) {
+            image.pixels.assign((const U8*)mapped, (const U8*)mapped + size);
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        if (image.pixels.empty()) {
+            mDropped++;
+        } else {
+            enqueue(std::move(image));
+        }
+    }
+}
+
+void VrModCapture::enqueue(Image&& image) {
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (mQueue.size() >= MAX_QUEUED) {
+            mDropped++;
+            return;
+        }
+        mQueue.push_back(std::move(image));
+    }
+    mWake.notify_one();
+}
+
+void VrModCapture::writerLoop() {
+    for (;;) {
+        Image image;
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mWake.wait(lock, [this] { return mStopping || !mQueue.empty(); });
+            if (mQueue.empty()) return; // stopping, and everything is written
+            image = std::move(mQueue.front());
+            mQueue.pop_front();
+        }
+        write(image);
+    }
+}
+
+void VrModCapture::write(Image& image) {
+    // top-down rows, opaque (the eye textures' alpha is not meaningful)
+    const size_t stride = (size_t)image.width * 4;
+    std::vector<U8> rgba(image.pixels.size());
+    for (S32 y = 0; y < image.height; ++y) {
+        memcpy(&rgba[y * stride], &image.pixels[(image.height - 1 - y) * stride], stride);
+    }
+    for (size_t i = 3; i < rgba.size(); i += 4) rgba[i] = 255;
+
+    const std::string& format = mFormat;
+    std::string name = llformat("frame%06u_%c", image.frame, image.eye);
+    if (format == "png") {
+        name += ".png";
+    } else if (format == "raw") {
+        name += llformat("_%dx%d.rgba", image.width, image.height);
+    } else {
+        name += ".qoi";
+    }
+    const std::string dir = capture_dir();
+    const std::string path = dir + gDirUtilp->getDirDelimiter() + name;
+
+    bool written = false;
+    if (format == "png") {
+        LLPointer<LLImageRaw> raw = new LLImageRaw(rgba.data(), image.width, image.height, 4);
+        LLPointer<LLImagePNG> png = new LLImagePNG;
+        written = png->encode(raw, 0.f) && png->save(path);
+    } else {
+        std::vector<U8> encoded;
+        if (format == "qoi") encoded = qoi_encode(rgba.data(), image.width, image.height);
+        std::vector<U8> const& bytes = format == "raw" ? rgba : encoded;
+        llofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write((const char*)bytes.data(), bytes.size());
+        written = out.good();
+    }
+    if (!written) {
+        LL_WARNS() << "VRMOD: could not write " << path << LL_ENDL;
+        return;
+    }
+    mWritten++;
+
+    const std::string reference = dir + gDirUtilp->getDirDelimiter() + "reference" + gDirUtilp->getDirDelimiter() + name;
+    std::vector<U8> expected;
+    S32 width = image.width, height = image.height;
+    if (!load_reference(reference, format, expected, width, height)) return;
+    if (width != image.width || height != image.height || expected.size() != rgba.size()) {
+        LL_WARNS() << "VRMOD: capture diff " << name << ": reference is " << width << "x" << height << LL_ENDL;
+        mDiffed++;
+        mDiffering++;
+        return;
+    }
+    const DiffResult diff = perceptual_diff(rgba.data(), expected.data(), width, height);
+    mDiffed++;
+    if (diff.differingPercent > 0.f) mDiffering++;
+    LL_WARNS() << "VRMOD: capture diff " << name << ": "
+               << llformat("%.3f%% of pixels differ perceptibly, PSNR %.1f dB", diff.differingPercent, diff.psnr) << LL_ENDL;
+}
+
+// Global instance, accessed from the main VR mod code.
+VrModCapture gVrModCapture;
@@ -0,0 +1,109 @@
+/*
+================================================================================
+VR MOD CULL: one visibility pass per HMD frame (humbletim 2026)
+================================================================================
+
+Each eye pass runs the whole of `display()`, including
+`gPipeline.updateCull()` and `gPipeline.stateSort()` against that eye's
+`LLViewerCamera` frustum. The two frusta differ by the eye separation (a
+few centimetres) and a slight toe-in towards the focus point, so the
+visible sets are all but identical.
+
+`0003-vrmod-far-field.patch` routes the cull through
+`llviewerVR::UpdateCull()`, `0004-vrmod-shared-cull.patch` the state sort
+through `StateSort()`. With `vrmod.sharedCull`:
+
+-   the first (left) pass culls with a conservative frustum enclosing both
+    eyes: the same axes, widened horizontally by twice the toe-in angle and
+    pulled back behind the centre eye until its sides clear both eye
+    origins (`half separation / tan(half fov)`),
+-   the camera is restored to the left eye before anything is drawn,
+-   the right pass skips cull and state sort and renders the left pass's
+    sorted set as-is (alpha sorting and LOD are by the left / pulled-back
+    origin, a few centimetres off).
+
+With a far field split (VR MOD FAR FIELD) the far pass culls and sorts on
+its own; the eye passes after it share as above, within the split.
+
+Cull time per HMD frame and the visible group / drawable counts are
+reported as `VRMOD: timing cull` when VR mode is left, for both modes, so
+they can be compared on the same session.
+
+*/
+
+struct VrModCull {
+    bool mShared = false;  // this HMD frame's first pass culled for both eyes
+
+    // runs update_cull for the current pass, or skips it on the second pass
+    // of a shared frame; stereo is false when both eyes come from one pass
+    void cull(LLCullResult& result, std::function<void()> const& update_cull, bool first_pass, bool stereo,
+              LLVector3 const& centre, F32 half_separation, F32 focus_distance);
+
+    // runs state_sort unless the pass reuses the first pass's set
+    void stateSort(std::function<void()> const& state_sort, bool first_pass);
+
+private:
+    static void enclose(LLCamera& camera, LLVector3 const& centre, F32 half_separation, F32 focus_distance);
+};
+
+void VrModCull::cull(LLCullResult& result, std::function<void()> const& update_cull, bool first_pass, bool stereo,
+                     LLVector3 const& centre, F32 half_separation, F32 focus_distance) {
+    if (!first_pass && mShared) {
+        gVrModTelemetry.cullSkipped();
+        return;
+    }
+
+    LLTimer timer;
+    mShared = first_pass && stereo && gVrModSettings->sharedCull;
+    if (mShared) {
+        LLCamera& camera = *LLViewerCamera::getInstance();
+        const LLCamera eye = camera;
+        enclose(camera, centre, half_separation, focus_distance);
+        update_cull();
+        camera = eye;
+    } else {
+        update_cull();
+    }
+    gVrModTelemetry.culled(timer.getElapsedTimeF64(), result.getVisibleGroupsSize(), result.getVisibleListSize());
+}
+
+void VrModCull::stateSort(std::function<void()> const& state_sort, bool first_pass) {
+    if (!first_pass && mShared) return;
+    state_sort();
+}
+
+/*static*/ void VrModCull::enclose(LLCamera& camera, LLVector3 const& centre, F32 half_separation, F32 focus_distance) {
+    const F32 aspect = camera.getAspect();
+    const F32 tan_half_v = tanf(camera.getView() * 0.5f);
+    const F32 half_h = atanf(tan_half_v * aspect);
+    const F32 toe_in = atan2f(half_separation, llmax(focus_distance, 0.1f));
+    const F32 wide_half_h = llmin(half_h + 2.f * toe_in, F_PI_BY_TWO * 0.95f);
+    const F32 tan_wide_h = tanf(wide_half_h);
+    const F32 tan_wide_v = tan_wide_h / aspect;
+    const F32 pullback = half_separation / tan_wide_h;
+
+    const LLVector3 origin = centre - camera.getAtAxis() * pullback;
+    camera.setOrigin(origin);
+
+    // the spatial partition culls against the agent planes, which the
+    // viewer derives from the eight frustum corners (near, then far; each
+    // bottom-left, bottom-right, top-right, top-left)
+    const LLVector3 right = -camera.getLeftAxis();
+    const LLVector3 up = camera.getUpAxis();
+    const LLVector3 at = camera.getAtAxis();
+    const F32 depths[2] = { camera.getNear(), camera.getFar() + pullback };
+    const F32 corners[4][2] = { { -1.f, -1.f }, { 1.f, -1.f }, { 1.f, 1.f }, { -1.f, 1.f } };
+    LLVector3 frust[8];
+    for (S32 plane = 0; plane < 2; ++plane) {
+        const F32 d = depths[plane];
+        for (S32 i = 0; i < 4; ++i) {
+            frust[plane * 4 + i] = origin + at * d
+                + right * (corners[i][0] * d * tan_wide_h)
+                + up * (corners[i][1] * d * tan_wide_v);
+        }
+    }
+    camera.calcAgentFrustumPlanes(frust);
+}
+
+// Global instance, accessed from the main VR mod code.
+VrModCull gVrModCull;
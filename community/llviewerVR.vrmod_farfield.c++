@@ -0,0 +1,298 @@
+/*
+================================================================================
+VR MOD FAR FIELD: the distant scene rendered once per HMD frame (humbletim 2026)
+================================================================================
+
+Past a few tens of metres the two eye views differ by less than a pixel
+(the `VRMOD: stereo disparity` log line gives the distance for the headset
+in use), yet each eye pass renders the whole scene out to the draw
+distance. With `vrmod.farFieldSplit` set to a distance in metres, an HMD
+frame takes three passes instead of two:
+
+-   **far pass:** the camera sits between the eyes, with its near plane at
+    the split. Whatever lies beyond is rendered once, and the finished
+    (post-processed) image is copied aside before any HUD or UI is drawn.
+    This pass draws no 2D UI, controller lasers or cursors.
+-   **eye passes:** each eye's camera has its far plane at the split, so
+    objects wholly beyond it are culled. Objects straddling the split are
+    still drawn whole, which is correct, just less of a saving. Right
+    after `renderFinalize()` the far image is composited wherever the
+    eye's scene depth is still clear: at the far plane, i.e. sky and
+    everything culled. The eye's HUD, UI and cursors are drawn on top as
+    usual.
+
+All three passes use the same projection, so the far image lines up pixel
+for pixel. Beyond the split it is off by at most half the eye separation's
+disparity, which is under half a pixel once the split is past the disparity
+horizon.
+
+`0003-vrmod-far-field.patch` routes `gPipeline.updateCull()` through
+`llviewerVR::UpdateCull()` (the eye passes' far plane), adds the hook after
+`renderFinalize()` (`llviewerVR::RenderFinalize()`), and lets the far pass
+re-enter `display()` for the left eye as the left eye pass does for the
+right (`goto sec`). The mask is drawn into the G-buffer's colour target with
+a depth test against its depth (`glDepthRange(1, 1)` puts the quad at the
+far plane). Nothing reads that target again once the frame is finalized.
+
+Sun shadows and the water reflection are rendered by the far pass for its
+own depth range and again by the left eye (`vrmod.sharePasses` still shares
+them between the eyes). Shared culling (`vrmod.sharedCull`) applies to the
+eye passes.
+
+The GPU time of every HMD frame, from its first pass to the end of its eye
+passes (`GL_TIMESTAMP` queries, read a few frames late), is reported as
+`VRMOD: timing farfield` when VR mode is left. Frames with and without the
+split are reported separately, so toggling the setting in one session
+compares them.
+
+*/
+
+struct VrModFarField {
+    enum Stage { STAGE_NONE, STAGE_FAR, STAGE_EYES };
+    enum Stamp { STAMP_BEGIN, STAMP_FAR, STAMP_EYES, STAMP_COUNT };
+    static const U32 FRAME_SLOTS = 8;
+
+    struct Frame {
+        GLuint queries[STAMP_COUNT] = {};
+        bool pending = false;
+        bool split = false;
+    };
+
+    Stage mStage = STAGE_NONE;
+    F32 mSplit = 0.f;      // this HMD frame's split distance (m), 0 without far pass
+    F32 mEyeNear = 0.f;    // the camera's near plane before the far pass moved it
+    LLRenderTarget mFar;   // the far pass's finished image
+
+    Frame mFrames[FRAME_SLOTS];
+    U32 mNext = 0;
+    S32 mTimed = -1;       // this HMD frame's slot, -1 when untimed
+
+    bool farPass() const { return mStage == STAGE_FAR; }
+    bool eyePass() const { return mStage == STAGE_EYES; }
+
+    // first pass of an HMD frame (ProcessVRCamera): makes it the far pass
+    // when a split is set and the eyes are apart
+    void beginFrame(bool stereo);
+
+    // eye passes, before culling: far plane at the split
+    void clipEyes(LLCamera& camera);
+
+    // right after renderFinalize(): the far pass keeps its image, the eye
+    // passes composite it behind their own
+    void finalized();
+
+    // vrDisplay() after the far pass: the eye passes follow
+    void farDone();
+
+    // vrDisplay() after the eye passes, before submit
+    void eyesDone();
+
+    void release();
+
+private:
+    void collect();
+    void stamp(Stamp stamp);
+    static F32 setCameraNear(F32 near_plane);
+    static void drawFullscreen(LLRenderTarget& texture);
+    void capture();
+    void composite();
+};
+
+void VrModFarField::beginFrame(bool stereo) {
+    collect();
+    mSplit = stereo ? llmax((F32)gVrModSettings->farFieldSplit, 0.f) : 0.f;
+
+    const U32 slot = mNext % FRAME_SLOTS;
+    mTimed = mFrames[slot].pending ? -1 : (S32)slot;
+    if (mTimed >= 0) {
+        if (!mFrames[slot].queries[0]) glGenQueries(STAMP_COUNT, mFrames[slot].queries);
+        mFrames[slot].split = mSplit > 0.f;
+        mNext++;
+    }
+    stamp(STAMP_BEGIN);
+
+    if (mSplit <= 0.f) return;
+    mStage = STAGE_FAR;
+    mEyeNear = setCameraNear(mSplit);
+}
+
+void VrModFarField::clipEyes(LLCamera& camera) {
+    if (!eyePass()) return;
+    camera.setFar(mSplit);
+
+    // the spatial partition culls against the agent planes, which the
+    // viewer derives from the eight frustum corners (near, then far; each
+    // bottom-left, bottom-right, top-right, top-left)
+    const LLVector3 origin = camera.getOrigin();
+    const LLVector3 right = -camera.getLeftAxis();
+    const LLVector3 up = camera.getUpAxis();
+    const LLVector3 at = camera.getAtAxis();
+    const F32 tan_v = tanf(camera.getView() * 0.5f);
+    const F32 tan_h = tan_v * camera.getAspect();
+    const F32 depths[2] = { camera.getNear(), camera.getFar() };
+    const F32 corners[4][2] = { { -1.f, -1.f }, { 1.f, -1.f }, { 1.f, 1.f }, { -1.f, 1.f } };
+    LLVector3 frust[8];
+    for (S32 plane = 0; plane < 2; ++plane) {
+        const F32 d = depths[plane];
+        for (S32 i = 0; i < 4; ++i) {
+            frust[plane * 4 + i] = origin + at * d + right * (corners[i][0] * d * tan_h) + up * (corners[i][1] * d * tan_v);
+        }
+    }
+    camera.calcAgentFrustumPlanes(frust);
+}
+
+void VrModFarField::finalized() {
+    if (farPass()) capture();
+    else if (eyePass()) composite();
+}
+
+void VrModFarField::farDone() {
+    stamp(STAMP_FAR);
+    setCameraNear(mEyeNear);
+    mStage = STAGE_EYES;
+}
+
+void VrModFarField::eyesDone() {
+    stamp(STAMP_EYES);
+    if (mTimed >= 0) mFrames[mTimed].pending = true;
+    mTimed = -1;
+    mStage = STAGE_NONE;
+}
+
+void VrModFarField::release() {
+    if (farPass()) setCameraNear(mEyeNear);
+    mStage = STAGE_NONE;
+    mTimed = -1;
+    mFar.release();
+    for (Frame& frame : mFrames) {
+        if (frame.queries[0]) glDeleteQueries(STAMP_COUNT, frame.queries);
+        frame = Frame();
+    }
+}
+
+void VrModFarField::collect() {
+    for (Frame& frame : mFrames) {
+        if (!frame.pending) continue;
+        GLuint available = 0;
+        glGetQueryObjectuiv(frame.queries[STAMP_EYES], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) continue;
+        GLuint64 stamps[STAMP_COUNT] = {};
+        for (S32 i = 0; i < STAMP_COUNT; ++i) {
+            if (i == STAMP_FAR && !frame.split) continue;
+            glGetQueryObjectui64v(frame.queries[i], GL_QUERY_RESULT, &stamps[i]);
+        }
+        frame.pending = false;
+        const GLuint64 far_end = frame.split ? stamps[STAMP_FAR] : stamps[STAMP_BEGIN];
+        gVrModTelemetry.farFieldTimed(frame.split, (F64)(far_end - stamps[STAMP_BEGIN]) * 1.0e-9,
+                                      (F64)(stamps[STAMP_EYES] - far_end) * 1.0e-9);
+    }
+}
+
+void VrModFarField::stamp(Stamp stamp) {
+    if (mTimed < 0) return;
+    // timestamps, unlike GL_TIME_ELAPSED, may fall inside the UI and pass timers
+    glQueryCounter(mFrames[mTimed].queries[stamp], GL_TIMESTAMP);
+}
+
+// moves the near plane past LLCamera::setNear()'s clamp, as ProcessVRCamera
+// does for vrmod.nearClip; returns the previous one
+/*static*/ F32 VrModFarField::setCameraNear(F32 near_plane) {
+    struct {
+        F32 mView;
+        F32 mAspect;
+        F32 mNearPlane;
+        F32 mFarPlane;
+    } frustum{};
+    LLViewerCamera::getInstance()->writeFrustumToBuffer(reinterpret_cast<char*>(&frustum));
+    const F32 previous = frustum.mNearPlane;
+    frustum.mNearPlane = near_plane;
+    LLViewerCamera::getInstance()->readFrustumFromBuffer(reinterpret_cast<const char*>(&frustum));
+    return previous;
+}
+
+/*static*/ void VrModFarField::drawFullscreen(LLRenderTarget& texture) {
+    gUIProgram.bind();
+    gGL.matrixMode(LLRender::MM_PROJECTION);
+    gGL.pushMatrix();
+    gGL.loadIdentity();
+    gGL.matrixMode(LLRender::MM_MODELVIEW);
+    gGL.pushMatrix();
+    gGL.loadIdentity();
+    gGL.getTexUnit(0)->bind(&texture);
+    gGL.color4f(1.f, 1.f, 1.f, 1.f);
+    gGL.begin(LLRender::TRIANGLE_STRIP);
+    gGL.texCoord2f(0.f, 0.f); gGL.vertex2f(-1.f, -1.f);
+    gGL.texCoord2f(1.f, 0.f); gGL.vertex2f(1.f, -1.f);
+    gGL.texCoord2f(0.f, 1.f); gGL.vertex2f(-1.f, 1.f);
+    gGL.texCoord2f(1.f, 1.f); gGL.vertex2f(1.f, 1.f);
+    gGL.end();
+    gGL.flush();
+    gGL.getTexUnit(0)->unbind(LLTexUnit::TT_TEXTURE);
+    gGL.matrixMode(LLRender::MM_PROJECTION);
+    gGL.popMatrix();
+    gGL.matrixMode(LLRender::MM_MODELVIEW);
+    gGL.popMatrix();
+    gUIProgram.unbind();
+}
+
+void VrModFarField::capture() {
+    const U32 width = gPipeline.mRT->screen.getWidth();
+    const U32 height = gPipeline.mRT->screen.getHeight();
+    if (!mFar.isComplete() || mFar.getWidth() != width || mFar.getHeight() != height) {
+        mFar.release();
+        if (!mFar.allocate(width, height, GL_RGBA, false)) {
+            LL_WARNS() << "VRMOD: could not allocate " << width << "x" << height << " far field target; rendering without the split" << LL_ENDL;
+            gSavedSettings.setF32("vrmod.farFieldSplit", 0.f);
+            return;
+        }
+    }
+
+    GLfloat clear_color[4];
+    glGetFloatv(GL_COLOR_CLEAR_VALUE, clear_color);
+    mFar.bindTarget();
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+    glReadBuffer(GL_BACK);
+    glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    // the back buffer's alpha is not the image's; the composite needs it opaque
+    gGL.setColorMask(false, true);
+    glClearColor(0.f, 0.f, 0.f, 1.f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    gGL.setColorMask(true, false);
+    glClearColor(clear_color[0], clear_color[1], clear_color[2], clear_color[3]);
+    mFar.flush();
+}
+
+void VrModFarField::composite() {
+    if (!mFar.isComplete()) return;
+    LLRenderTarget& scene = gPipeline.mRT->deferredScreen;
+
+    // 1. into the G-buffer's colour target (dead once finalized): the far
+    //    image where the eye's depth is still clear, transparent elsewhere
+    GLfloat clear_color[4];
+    glGetFloatv(GL_COLOR_CLEAR_VALUE, clear_color);
+    scene.bindTarget();
+    gGL.setColorMask(true, true);
+    glClearColor(0.f, 0.f, 0.f, 0.f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glClearColor(clear_color[0], clear_color[1], clear_color[2], clear_color[3]);
+    {
+        LLGLDepthTest depth(GL_TRUE, GL_FALSE, GL_LEQUAL);
+        LLGLDisable blend(GL_BLEND);
+        LLGLDisable cull(GL_CULL_FACE);
+        glDepthRange(1.0, 1.0);
+        drawFullscreen(mFar);
+        glDepthRange(0.0, 1.0);
+    }
+    gGL.setColorMask(true, false);
+    scene.flush();
+
+    // 2. over the eye's finished image in the back buffer
+    LLGLDepthTest no_depth(GL_FALSE, GL_FALSE);
+    LLGLEnable blend(GL_BLEND);
+    gGL.blendFunc(LLRender::BF_ONE, LLRender::BF_ONE_MINUS_SOURCE_ALPHA);
+    drawFullscreen(scene);
+    gGL.setSceneBlendType(LLRender::BT_ALPHA);
+}
+
+// Global instance, accessed from the main VR mod code.
+VrModFarField gVrModFarField;
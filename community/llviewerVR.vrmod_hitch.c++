@@ -0,0 +1,307 @@
+/*
+================================================================================
+VR MOD HITCH: snapshot the last frames when one misses the HMD frame budget (humbletim 2026)
+================================================================================
+
+Dropped frames in VR mode are sporadic: the session averages written to the
+log when leaving VR mode (VR MOD TELEMETRY) smooth them away, and by the time
+a user notices the stutter it is gone. This keeps a ring of the last
+`RING_FRAMES` HMD frames, each split into stages:
+
+    render    end of the previous HMD frame to its eye images being ready
+              (both eye renders, plus whatever the viewer did in between);
+              of which, from VR MOD TELEMETRY's counters:
+                input   controller polling
+                ui      2D UI drawing
+                cull    culling
+                passes  shadow / water reflection passes (CPU side)
+    capture   VR MOD CAPTURE readback
+    submit    handing the eye images to the runtime
+    swap      the desktop window's swapBuffers
+    wait      WaitGetPoses (VrModRuntime::waitFrame): pacing to the display
+    events    runtime events and pointer dispatch
+
+When a frame interval exceeds `vrmod.hitchThreshold` times the HMD frame
+budget (1 / `Prop_DisplayFrequency_Float`; 1.5 catches one missed vsync),
+the ring is frozen into `logs/vrmod_hitch_<n>.txt` together with the
+tracked devices and the `vrmod.json` settings, so a user report can carry
+the frames leading up to the hitch.
+
+The render thread only copies the ring, the device states and the settings
+into a `Dump` and queues it; a writer thread (as in VR MOD CAPTURE) formats
+and writes the file, so a dump does not itself cause the next hitch.
+
+Dumps are rate-limited: at most one per `vrmod.hitchDumpInterval` seconds
+and `MAX_DUMPS` per VR session (the files are reused by the next session).
+Hitches in between are counted and reported in the next dump and, with the
+worst interval, as `VRMOD: timing hitches` when leaving VR mode.
+
+*/
+
+#include "lldate.h"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+struct VrModHitch {
+    enum Stage { STAGE_RENDER, STAGE_CAPTURE, STAGE_SUBMIT, STAGE_SWAP, STAGE_WAIT, STAGE_EVENTS, STAGE_COUNT };
+    static constexpr const char* STAGE_NAMES[STAGE_COUNT] = { "render", "capture", "submit", "swap", "wait", "events" };
+    static const U32 RING_FRAMES = 120;
+    static const U32 MAX_DUMPS = 10;
+
+    struct Frame {
+        U32 frame = 0;
+        F32 interval = 0.f;            // ms since the previous HMD frame ended
+        F32 stages[STAGE_COUNT] = {};  // ms
+        F32 input = 0.f, ui = 0.f, cull = 0.f, passes = 0.f;  // ms, part of render
+        U8 validPoses = 0;
+    };
+
+    // everything a hitch file shows, copied on the render thread
+    struct Device {
+        vr::TrackedDeviceIndex_t index;
+        vr::ETrackedDeviceClass deviceClass;
+        bool connected, valid;
+        S32 trackingResult;
+    };
+    struct Dump {
+        U32 number;
+        std::string date;
+        std::string runtime;
+        F32 budget, threshold;
+        U32 hitches, hitchesSinceDump;
+        std::vector<Frame> frames;  // oldest first; the hitch is the last one
+        std::vector<Device> devices;
+        std::string settings;
+    };
+
+    Frame mRing[RING_FRAMES];
+    U32 mFrames = 0;             // frames recorded this session; mRing[mFrames % RING_FRAMES] is next
+    Frame mCurrent;
+    F64 mLapAt = 0.0;
+    F64 mFrameEndAt = 0.0;
+    F32 mBudget = 0.f;           // ms
+
+    std::thread mWriter;
+    std::mutex mMutex;
+    std::condition_variable mWake;
+    std::deque<Dump> mQueue;
+    bool mStopping = false;
+
+    // VR MOD TELEMETRY's running sums at the previous frame end
+    F64 mInputSum = 0.0, mUiSum = 0.0, mCullSum = 0.0, mPassesSum = 0.0;
+
+    U32 mHitches = 0;
+    U32 mHitchesSinceDump = 0;
+    U32 mDumps = 0;
+    F64 mLastDumpAt = 0.0;
+    F32 mWorst = 0.f;
+
+    // VR mode entered (after VrModTelemetry::activated)
+    void activated(F32 display_frequency);
+
+    // closes the stage that ended now; stages run in Stage order
+    void lap(Stage stage);
+
+    // HMD frame done: closes STAGE_EVENTS, records the frame and dumps the
+    // ring if it missed the budget
+    void frameEnd(VrModRuntime* runtime, const vr::TrackedDevicePose_t* poses);
+
+    // VR mode left; reports the session's hitches and finishes outstanding
+    // dumps
+    void deactivated();
+
+    // shut down: finishes outstanding dumps
+    void stop();
+
+private:
+    void telemetryDeltas(Frame& frame);
+    void dump(VrModRuntime* runtime, const vr::TrackedDevicePose_t* poses);
+    void writerLoop();
+    static void write(Dump const& dump);
+};
+
+namespace {
+    const char* vrmod_device_class_name(vr::ETrackedDeviceClass device_class) {
+        switch (device_class) {
+        case vr::TrackedDeviceClass_HMD:               return "hmd";
+        case vr::TrackedDeviceClass_Controller:        return "controller";
+        case vr::TrackedDeviceClass_GenericTracker:    return "tracker";
+        case vr::TrackedDeviceClass_TrackingReference: return "base station";
+        case vr::TrackedDeviceClass_DisplayRedirect:   return "display redirect";
+        default:                                       return "invalid";
+        }
+    }
+} // namespace
+
+void VrModHitch::activated(F32 display_frequency) {
+    mBudget = display_frequency > 0.f ? 1000.f / display_frequency : 0.f;
+    mFrames = 0;
+    mCurrent = Frame();
+    mLapAt = mFrameEndAt = 0.0;
+    mInputSum = mUiSum = mCullSum = mPassesSum = 0.0;
+    mHitches = mHitchesSinceDump = mDumps = 0;
+    mLastDumpAt = 0.0;
+    mWorst = 0.f;
+    if (!mBudget) {
+        LL_WARNS() << "VRMOD: runtime reports no display frequency; hitch detection is off" << LL_ENDL;
+    }
+}
+
+void VrModHitch::lap(Stage stage) {
+    const F64 now = LLTimer::getTotalSeconds();
+    // the first frame has no start; its render stage is left at zero
+    if (mLapAt > 0.0) mCurrent.stages[stage] = (F32)((now - mLapAt) * 1000.0);
+    mLapAt = now;
+}
+
+void VrModHitch::telemetryDeltas(Frame& frame) {
+    VrModTelemetry const& telemetry = gVrModTelemetry;
+    const F64 input = telemetry.mInputSeconds[0] + telemetry.mInputSeconds[1];
+    F64 passes = 0.0;
+    for (S32 pass = 0; pass < VrModTelemetry::PASS_STATS; ++pass) passes += telemetry.mPasses[pass].cpuSeconds;
+
+    frame.input = (F32)((input - mInputSum) * 1000.0);
+    frame.ui = (F32)((telemetry.mUiCpuSeconds - mUiSum) * 1000.0);
+    frame.cull = (F32)((telemetry.mCullSeconds - mCullSum) * 1000.0);
+    frame.passes = (F32)((passes - mPassesSum) * 1000.0);
+    mInputSum = input;
+    mUiSum = telemetry.mUiCpuSeconds;
+    mCullSum = telemetry.mCullSeconds;
+    mPassesSum = passes;
+}
+
+void VrModHitch::frameEnd(VrModRuntime* runtime, const vr::TrackedDevicePose_t* poses) {
+    lap(STAGE_EVENTS);
+    const F64 now = mLapAt;
+
+    Frame& frame = mRing[mFrames % RING_FRAMES];
+    frame = mCurrent;
+    frame.frame = mFrames++;
+    frame.interval = mFrameEndAt > 0.0 ? (F32)((now - mFrameEndAt) * 1000.0) : 0.f;
+    telemetryDeltas(frame);
+    frame.validPoses = 0;
+    for (U32 device = 0; device < vr::k_unMaxTrackedDeviceCount; ++device) {
+        if (poses[device].bPoseIsValid) frame.validPoses++;
+    }
+    mCurrent = Frame();
+    mFrameEndAt = now;
+
+    if (!mBudget || frame.interval <= mBudget * llmax((F32)gVrModSettings->hitchThreshold, 1.f)) return;
+
+    mHitches++;
+    mHitchesSinceDump++;
+    mWorst = llmax(mWorst, frame.interval);
+    if (!gVrModSettings->hitchDumps || mDumps >= MAX_DUMPS) return;
+    if (mLastDumpAt > 0.0 && now - mLastDumpAt < (F32)gVrModSettings->hitchDumpInterval) return;
+    dump(runtime, poses);
+    mLastDumpAt = now;
+    mHitchesSinceDump = 0;
+}
+
+void VrModHitch::dump(VrModRuntime* runtime, const vr::TrackedDevicePose_t* poses) {
+    Dump dump;
+    dump.number = ++mDumps;
+    dump.date = LLDate::now().asString();
+    dump.runtime = runtime->name();
+    dump.budget = mBudget;
+    dump.threshold = llmax((F32)gVrModSettings->hitchThreshold, 1.f);
+    dump.hitches = mHitches;
+    dump.hitchesSinceDump = mHitchesSinceDump;
+    const U32 count = llmin(mFrames, RING_FRAMES);
+    dump.frames.reserve(count);
+    for (U32 i = mFrames - count; i < mFrames; ++i) dump.frames.push_back(mRing[i % RING_FRAMES]);
+    for (U32 device = 0; device < vr::k_unMaxTrackedDeviceCount; ++device) {
+        vr::TrackedDevicePose_t const& pose = poses[device];
+        const bool connected = runtime->deviceConnected(device);
+        if (!pose.bPoseIsValid && !pose.bDeviceIsConnected && !connected) continue;
+        dump.devices.push_back({ device, runtime->deviceClass(device), connected, pose.bPoseIsValid, (S32)pose.eTrackingResult });
+    }
+    dump.settings = gVrModSettings->mJsonBlob->getValue().asString();
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (!mWriter.joinable()) {
+            mStopping = false;
+            mWriter = std::thread([this] { writerLoop(); });
+        }
+        mQueue.push_back(std::move(dump));
+    }
+    mWake.notify_one();
+}
+
+void VrModHitch::writerLoop() {
+    for (;;) {
+        Dump dump;
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mWake.wait(lock, [this] { return mStopping || !mQueue.empty(); });
+            if (mQueue.empty()) return; // stopping, and everything is written
+            dump = std::move(mQueue.front());
+            mQueue.pop_front();
+        }
+        write(dump);
+    }
+}
+
+/*static*/ void VrModHitch::write(Dump const& dump) {
+    const std::string path = gDirUtilp->getExpandedFilename(LL_PATH_LOGS, llformat("vrmod_hitch_%u.txt", dump.number));
+    llofstream out(path, std::ios::trunc);
+    if (!out.is_open()) {
+        LL_WARNS() << "VRMOD: could not create " << path << LL_ENDL;
+        return;
+    }
+
+    Frame const& hitch = dump.frames.back();
+    out << "VRMOD hitch " << dump.date << "\n"
+        << llformat("frame %u took %.2f ms; budget %.2f ms (%.1f Hz, %s), threshold x%.2f\n",
+                    hitch.frame, hitch.interval, dump.budget, 1000.f / dump.budget, dump.runtime.c_str(), dump.threshold)
+        << llformat("hitches this session %u, since the previous dump %u\n\n", dump.hitches, dump.hitchesSinceDump);
+
+    out << "frames (ms; input/ui/cull/passes are part of render)\n"
+        << "  frame interval";
+    for (S32 stage = 0; stage < STAGE_COUNT; ++stage) out << " " << STAGE_NAMES[stage];
+    out << " | input ui cull passes | poses\n";
+    for (Frame const& frame : dump.frames) {
+        out << llformat("  %u %.2f", frame.frame, frame.interval);
+        for (S32 stage = 0; stage < STAGE_COUNT; ++stage) out << llformat(" %.2f", frame.stages[stage]);
+        out << llformat(" | %.2f %.2f %.2f %.2f | %u", frame.input, frame.ui, frame.cull, frame.passes, frame.validPoses)
+            << (frame.interval > dump.budget * dump.threshold ? " *" : "") << "\n";
+    }
+
+    out << "\ndevices\n";
+    for (Device const& device : dump.devices) {
+        out << llformat("  %u %s, %s, pose %s, tracking result %d\n", device.index,
+                        vrmod_device_class_name(device.deviceClass),
+                        device.connected ? "connected" : "disconnected",
+                        device.valid ? "valid" : "invalid", device.trackingResult);
+    }
+
+    out << "\nsettings\n  " << dump.settings << "\n";
+    out.close();
+
+    LL_WARNS() << "VRMOD: hitch frame " << hitch.frame << " took " << llformat("%.2f ms (budget %.2f ms)", hitch.interval, dump.budget)
+               << "; last " << dump.frames.size() << " frames written to " << path << LL_ENDL;
+}
+
+void VrModHitch::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (!mWriter.joinable()) return;
+        mStopping = true;
+    }
+    mWake.notify_all();
+    mWriter.join();
+}
+
+void VrModHitch::deactivated() {
+    stop();
+    if (!mHitches) return;
+    LL_WARNS() << "VRMOD: timing hitches over " << mFrames << " frames: " << mHitches
+               << llformat(" missed the %.2f ms budget (worst %.2f ms), ", mBudget, mWorst)
+               << mDumps << " dumped to logs/vrmod_hitch_*.txt" << LL_ENDL;
+}
+
+// Global instance, accessed from the main VR mod code.
+VrModHitch gVrModHitch;
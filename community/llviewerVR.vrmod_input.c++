@@ -0,0 +1,249 @@
+/*
+================================================================================
+VR MOD INPUT: SteamVR Input (IVRInput) actions for the hand controllers (humbletim 2026)
+================================================================================
+
+The controller loop used to poll `GetControllerState` per device, per eye
+pass, and read the stick from a hardcoded `rAxis[2]` with the trigger/grip
+from raw button masks. That axis is the trackpad on Vive wands but nothing
+useful on Index or WMR controllers.
+
+Instead three actions are declared in an action manifest:
+
+    /actions/main/in/click    boolean   trigger  -> left mouse button
+    /actions/main/in/context  boolean   grip     -> right mouse button
+    /actions/main/in/move     vector2   stick / trackpad -> turn and walk
+
+The manifest and default bindings (Index, Vive, Oculus Touch, WMR) are
+bundled here. They are written to `user_settings/vrmod_input/` when VR
+starts, and users can rebind them in the SteamVR bindings UI as with any
+other application. `UpdateActionState` runs once per HMD frame, and the
+left / right hand actions are copied into a small per-device struct that
+the controller loop reads.
+
+`vrmod.legacyInput` switches back to the old per-device polling (also used
+automatically if the manifest is rejected), so both paths can be compared
+on the same session. Time spent in either is reported per frame as
+`VRMOD: timing input` when VR mode is left.
+
+*/
+
+#include "lldir.h"
+#include "llframetimer.h"
+#include <boost/json.hpp> // action manifest / bindings
+
+struct VrModInput {
+    struct ControllerActions {
+        bool click = false;    // trigger
+        bool context = false;  // grip
+        LLVector2 move;        // stick / trackpad, -1..1
+    };
+
+    bool mReady = false;
+    vr::VRActionSetHandle_t mActionSet = vr::k_ulInvalidActionSetHandle;
+    vr::VRActionHandle_t mClick = vr::k_ulInvalidActionHandle;
+    vr::VRActionHandle_t mContext = vr::k_ulInvalidActionHandle;
+    vr::VRActionHandle_t mMove = vr::k_ulInvalidActionHandle;
+    vr::VRInputValueHandle_t mHands[2] = { vr::k_ulInvalidInputValueHandle, vr::k_ulInvalidInputValueHandle };
+
+    U32 mFrame = 0;
+    bool mValid[vr::k_unMaxTrackedDeviceCount] = {};
+    ControllerActions mActions[vr::k_unMaxTrackedDeviceCount];
+
+    // writes the bundled manifest + bindings and registers them with the
+    // runtime; runs on the startup worker
+    bool init();
+
+    // actions for one tracked device this frame; false if it has none
+    bool get(vr::IVRSystem* hmd, vr::TrackedDeviceIndex_t device, ControllerActions& out);
+
+private:
+    void update(vr::IVRSystem* hmd);
+    bool pollLegacy(vr::IVRSystem* hmd, vr::TrackedDeviceIndex_t device, ControllerActions& out);
+};
+
+namespace {
+    const char* VRMOD_ACTION_SET = "/actions/main";
+    const char* VRMOD_ACTION_CLICK = "/actions/main/in/click";
+    const char* VRMOD_ACTION_CONTEXT = "/actions/main/in/context";
+    const char* VRMOD_ACTION_MOVE = "/actions/main/in/move";
+
+    struct VrModBindingProfile {
+        const char* controllerType;
+        const char* stick;      // input path below /user/hand/<side>/input/
+        const char* stickMode;  // joystick | trackpad
+        const char* gripMode;   // button | grab
+        const char* gripInput;  // click | grab
+    };
+
+    const VrModBindingProfile BINDING_PROFILES[] = {
+        { "knuckles",              "thumbstick", "joystick", "grab",   "grab"  },
+        { "vive_controller",       "trackpad",   "trackpad", "button", "click" },
+        { "oculus_touch",          "joystick",   "joystick", "button", "click" },
+        { "holographic_controller", "joystick",  "joystick", "button", "click" },
+    };
+
+    boost::json::object binding_source(std::string const& path, const char* mode, const char* input, const char* output) {
+        return {
+            { "path", path },
+            { "mode", mode },
+            { "inputs", boost::json::object{ { input, boost::json::object{ { "output", output } } } } },
+        };
+    }
+
+    boost::json::object binding_document(VrModBindingProfile const& profile) {
+        boost::json::array sources;
+        for (const char* side : { "left", "right" }) {
+            std::string input = std::string("/user/hand/") + side + "/input/";
+            sources.push_back(binding_source(input + "trigger", "button", "click", VRMOD_ACTION_CLICK));
+            sources.push_back(binding_source(input + "grip", profile.gripMode, profile.gripInput, VRMOD_ACTION_CONTEXT));
+            sources.push_back(binding_source(input + profile.stick, profile.stickMode, "position", VRMOD_ACTION_MOVE));
+        }
+        return {
+            { "controller_type", profile.controllerType },
+            { "description", "VR Mod defaults" },
+            { "bindings", boost::json::object{ { VRMOD_ACTION_SET, boost::json::object{ { "sources", sources } } } } },
+        };
+    }
+
+    boost::json::object manifest_document() {
+        boost::json::array default_bindings;
+        for (auto const& profile : BINDING_PROFILES) {
+            default_bindings.push_back({
+                { "controller_type", profile.controllerType },
+                { "binding_url", std::string("bindings_") + profile.controllerType + ".json" },
+            });
+        }
+        return {
+            { "default_bindings", default_bindings },
+            { "actions", boost::json::array{
+                boost::json::object{ { "name", VRMOD_ACTION_CLICK }, { "type", "boolean" } },
+                boost::json::object{ { "name", VRMOD_ACTION_CONTEXT }, { "type", "boolean" } },
+                boost::json::object{ { "name", VRMOD_ACTION_MOVE }, { "type", "vector2" } },
+            } },
+            { "action_sets", boost::json::array{
+                boost::json::object{ { "name", VRMOD_ACTION_SET }, { "usage", "leftright" } },
+            } },
+            { "localization", boost::json::array{
+                boost::json::object{
+                    { "language_tag", "en_US" },
+                    { VRMOD_ACTION_SET, "VR Mod" },
+                    { VRMOD_ACTION_CLICK, "Click (left mouse button)" },
+                    { VRMOD_ACTION_CONTEXT, "Context menu (right mouse button)" },
+                    { VRMOD_ACTION_MOVE, "Turn / walk" },
+                },
+            } },
+        };
+    }
+
+    // only rewrites files whose content changed, so the runtime's own
+    // binding cache isn't invalidated on every start
+    bool write_if_changed(std::string const& path, std::string const& content) {
+        llifstream in(path, std::ios::binary);
+        if (in.is_open()) {
+            std::string existing((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+            if (existing == content) return true;
+            in.close();
+        }
+        llofstream out(path, std::ios::binary | std::ios::trunc);
+        out << content;
+        return out.good();
+    }
+} // namespace
+
+bool VrModInput::init() {
+    mReady = false;
+    vr::IVRInput* input = vr::VRInput();
+    if (!input) return false;
+
+    std::string dir = gDirUtilp->getExpandedFilename(LL_PATH_USER_SETTINGS, "vrmod_input");
+    LLFile::mkdir(dir);
+    for (auto const& profile : BINDING_PROFILES) {
+        std::string path = dir + gDirUtilp->getDirDelimiter() + "bindings_" + profile.controllerType + ".json";
+        if (!write_if_changed(path, boost::json::serialize(binding_document(profile)))) {
+            LL_WARNS() << "VRMOD: could not write " << path << LL_ENDL;
+        }
+    }
+    std::string manifest = dir + gDirUtilp->getDirDelimiter() + "actions.json";
+    if (!write_if_changed(manifest, boost::json::serialize(manifest_document()))) {
+        LL_WARNS() << "VRMOD: could not write " << manifest << "; using legacy controller polling" << LL_ENDL;
+        return false;
+    }
+
+    vr::EVRInputError err = input->SetActionManifestPath(manifest.c_str());
+    if (err == vr::VRInputError_None) err = input->GetActionSetHandle(VRMOD_ACTION_SET, &mActionSet);
+    if (err == vr::VRInputError_None) err = input->GetActionHandle(VRMOD_ACTION_CLICK, &mClick);
+    if (err == vr::VRInputError_None) err = input->GetActionHandle(VRMOD_ACTION_CONTEXT, &mContext);
+    if (err == vr::VRInputError_None) err = input->GetActionHandle(VRMOD_ACTION_MOVE, &mMove);
+    if (err == vr::VRInputError_None) err = input->GetInputSourceHandle("/user/hand/left", &mHands[0]);
+    if (err == vr::VRInputError_None) err = input->GetInputSourceHandle("/user/hand/right", &mHands[1]);
+    if (err != vr::VRInputError_None) {
+        LL_WARNS() << "VRMOD: action manifest rejected (EVRInputError " << (S32)err << "); using legacy controller polling" << LL_ENDL;
+        return false;
+    }
+    mFrame = 0;
+    mReady = true;
+    return true;
+}
+
+void VrModInput::update(vr::IVRSystem* hmd) {
+    std::fill(std::begin(mValid), std::end(mValid), false);
+
+    vr::VRActiveActionSet_t active = {};
+    active.ulActionSet = mActionSet;
+    active.ulRestrictedToDevice = vr::k_ulInvalidInputValueHandle;
+    vr::IVRInput* input = vr::VRInput();
+    if (input->UpdateActionState(&active, sizeof(active), 1) != vr::VRInputError_None) return;
+
+    const vr::ETrackedControllerRole roles[2] = { vr::TrackedControllerRole_LeftHand, vr::TrackedControllerRole_RightHand };
+    for (S32 hand = 0; hand < 2; ++hand) {
+        vr::TrackedDeviceIndex_t device = hmd->GetTrackedDeviceIndexForControllerRole(roles[hand]);
+        if (device == vr::k_unTrackedDeviceIndexInvalid || device >= vr::k_unMaxTrackedDeviceCount) continue;
+
+        vr::InputDigitalActionData_t click = {}, context = {};
+        vr::InputAnalogActionData_t move = {};
+        input->GetDigitalActionData(mClick, &click, sizeof(click), mHands[hand]);
+        input->GetDigitalActionData(mContext, &context, sizeof(context), mHands[hand]);
+        input->GetAnalogActionData(mMove, &move, sizeof(move), mHands[hand]);
+
+        ControllerActions& actions = mActions[device];
+        actions.click = click.bActive && click.bState;
+        actions.context = context.bActive && context.bState;
+        actions.move = move.bActive ? LLVector2(move.x, move.y) : LLVector2::zero;
+        mValid[device] = true;
+    }
+}
+
+bool VrModInput::pollLegacy(vr::IVRSystem* hmd, vr::TrackedDeviceIndex_t device, ControllerActions& out) {
+    vr::VRControllerState_t state;
+    if (!hmd->GetControllerState(device, &state, sizeof(state)))
+        return false;
+    out.click = (state.ulButtonPressed & vr::ButtonMaskFromId(vr::k_EButton_SteamVR_Trigger)) != 0;
+    out.context = (state.ulButtonPressed & vr::ButtonMaskFromId(vr::k_EButton_Grip)) != 0;
+    out.move.set(state.rAxis[2].x, state.rAxis[2].y);
+    // the legacy stick only turned for controllers with an assigned hand
+    if (!hmd->GetControllerRoleForTrackedDeviceIndex(device))
+        out.move.mV[VX] = 0.f;
+    return true;
+}
+
+bool VrModInput::get(vr::IVRSystem* hmd, vr::TrackedDeviceIndex_t device, ControllerActions& out) {
+    F64 start = LLTimer::getTotalSeconds();
+    bool legacy = !mReady || gVrModSettings->legacyInput;
+    bool valid;
+    if (legacy) {
+        valid = pollLegacy(hmd, device, out);
+    } else {
+        if (mFrame != LLFrameTimer::getFrameCount()) {
+            mFrame = LLFrameTimer::getFrameCount();
+            update(hmd);
+        }
+        valid = mValid[device];
+        if (valid) out = mActions[device];
+    }
+    gVrModTelemetry.inputPolled(LLTimer::getTotalSeconds() - start, legacy);
+    return valid;
+}
+
+// Global instance, accessed from the main VR mod code.
+VrModInput gVrModInput;
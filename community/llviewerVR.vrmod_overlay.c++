@@ -0,0 +1,162 @@
+/*
+================================================================================
+VR MOD OVERLAY: the desktop UI as a SteamVR overlay quad (humbletim 2026)
+================================================================================
+
+By default the UI reaches the headset baked into the world view: the cached
+UI layer is composited over each eye's render, and `vrDisplay()` pans and
+zooms the combined frame towards one of nine screen regions under the mouse
+(`m_iZoomIndex`) so floaters near the edges can be read. World and UI share
+that one blit, and the UI judders whenever the scene drops frames.
+
+With `vrmod.uiOverlay` the UI layer is handed to the compositor instead:
+
+-   the layer texture becomes an `IVROverlay` quad, `vrmod.uiOverlayWidth`
+    metres wide and `vrmod.uiOverlayDistance` metres in front of the seated
+    origin (re-centre with the usual SteamVR seated reset),
+-   it is only resubmitted (`SetOverlayTexture`) when the layer was redrawn,
+    and the compositor reprojects it at full refresh on its own,
+-   the world is rendered without the UI and blitted without the pan-and-zoom
+    regions,
+-   SteamVR's laser mouse works on the quad; its events are fed to the same
+    in-process pointer queue as the controller clicks (VR MOD POINTER).
+
+The layer is the window's resolution. OpenVR 1.6 has no premultiplied-alpha
+overlay flag, so translucent floater backgrounds blend slightly darker than
+on the desktop.
+
+*/
+
+struct VrModOverlay {
+    vr::VROverlayHandle_t mHandle = vr::k_ulOverlayHandleInvalid;
+    bool mVisible = false;
+    bool mFailed = false;     // creation failed; don't retry every frame
+    S32 mWidth = 0, mHeight = 0;  // scaled window size the mouse scale was set for
+
+    // true while the UI goes to the overlay instead of into the eye views
+    bool active() const { return mVisible; }
+
+    // shows the overlay (creating it on first use) if vrmod.uiOverlay is set,
+    // hides it otherwise; returns active()
+    bool update();
+
+    // submits a freshly drawn UI layer (GL texture, bottom-left origin)
+    void submit(GLuint texture);
+
+    // feeds SteamVR laser mouse events on the quad to gVrModPointer
+    void pollEvents();
+
+    void hide();
+
+    // before VR_Shutdown
+    void destroy();
+
+private:
+    bool create();
+    void place();
+};
+
+bool VrModOverlay::update() {
+    if (!gVrModSettings->uiOverlay || mFailed || !vr::VROverlay()) {
+        hide();
+        return false;
+    }
+    if (mHandle == vr::k_ulOverlayHandleInvalid && !create()) {
+        return false;
+    }
+    place();
+    if (!mVisible) {
+        vr::VROverlay()->ShowOverlay(mHandle);
+        mVisible = true;
+    }
+    return true;
+}
+
+bool VrModOverlay::create() {
+    vr::EVROverlayError err = vr::VROverlay()->CreateOverlay("firestorm.vrmod.ui", "Firestorm VR Mod UI", &mHandle);
+    if (err != vr::VROverlayError_None) {
+        LL_WARNS() << "VRMOD: could not create the UI overlay (" << vr::VROverlay()->GetOverlayErrorNameFromEnum(err)
+                   << "); compositing the UI into the eye views" << LL_ENDL;
+        mHandle = vr::k_ulOverlayHandleInvalid;
+        mFailed = true;
+        return false;
+    }
+    // GL textures are bottom-up; overlays are sampled top-down
+    vr::VRTextureBounds_t bounds = { 0.f, 1.f, 1.f, 0.f };
+    vr::VROverlay()->SetOverlayTextureBounds(mHandle, &bounds);
+    vr::VROverlay()->SetOverlayInputMethod(mHandle, vr::VROverlayInputMethod_Mouse);
+    vr::VROverlay()->SetOverlayFlag(mHandle, vr::VROverlayFlags_MakeOverlaysInteractiveIfVisible, true);
+    mWidth = mHeight = 0;
+    return true;
+}
+
+void VrModOverlay::place() {
+    vr::VROverlay()->SetOverlayWidthInMeters(mHandle, llmax((F32)gVrModSettings->uiOverlayWidth, 0.1f));
+
+    vr::HmdMatrix34_t transform = {{
+        { 1.f, 0.f, 0.f, 0.f },
+        { 0.f, 1.f, 0.f, 0.f },
+        { 0.f, 0.f, 1.f, -llmax((F32)gVrModSettings->uiOverlayDistance, 0.1f) },
+    }};
+    vr::VROverlay()->SetOverlayTransformAbsolute(mHandle, vr::VRCompositor()->GetTrackingSpace(), &transform);
+
+    const S32 width = gViewerWindow->getWindowWidthScaled();
+    const S32 height = gViewerWindow->getWindowHeightScaled();
+    if (width != mWidth || height != mHeight) {
+        // laser mouse events arrive in scaled window units
+        vr::HmdVector2_t scale = { { (float)width, (float)height } };
+        vr::VROverlay()->SetOverlayMouseScale(mHandle, &scale);
+        mWidth = width;
+        mHeight = height;
+    }
+}
+
+void VrModOverlay::submit(GLuint texture) {
+    if (!mVisible) return;
+    vr::Texture_t tex = { (void*)(uintptr_t)texture, vr::TextureType_OpenGL, vr::ColorSpace_Gamma };
+    vr::EVROverlayError err = vr::VROverlay()->SetOverlayTexture(mHandle, &tex);
+    if (err != vr::VROverlayError_None) {
+        LL_WARNS() << "VRMOD: SetOverlayTexture failed (" << vr::VROverlay()->GetOverlayErrorNameFromEnum(err) << ")" << LL_ENDL;
+    }
+}
+
+void VrModOverlay::pollEvents() {
+    if (!mVisible) return;
+    vr::VREvent_t event;
+    while (vr::VROverlay()->PollNextOverlayEvent(mHandle, &event, sizeof(event))) {
+        // overlay mouse coordinates have a bottom-left origin
+        LLCoordWindow pos(ll_round(event.data.mouse.x), ll_round(mHeight - event.data.mouse.y));
+        const bool right = event.data.mouse.button == vr::VRMouseButton_Right;
+        switch (event.eventType) {
+        case vr::VREvent_MouseMove:
+            gVrModPointer.push(VrModPointer::MOVE, pos);
+            break;
+        case vr::VREvent_MouseButtonDown:
+            gVrModPointer.push(right ? VrModPointer::RIGHT_DOWN : VrModPointer::LEFT_DOWN, pos);
+            break;
+        case vr::VREvent_MouseButtonUp:
+            gVrModPointer.push(right ? VrModPointer::RIGHT_UP : VrModPointer::LEFT_UP, pos);
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+void VrModOverlay::hide() {
+    if (!mVisible) return;
+    vr::VROverlay()->HideOverlay(mHandle);
+    mVisible = false;
+}
+
+void VrModOverlay::destroy() {
+    if (mHandle != vr::k_ulOverlayHandleInvalid && vr::VROverlay()) {
+        vr::VROverlay()->DestroyOverlay(mHandle);
+    }
+    mHandle = vr::k_ulOverlayHandleInvalid;
+    mVisible = false;
+    mFailed = false;
+}
+
+// Global instance, accessed from the main VR mod code.
+VrModOverlay gVrModOverlay;
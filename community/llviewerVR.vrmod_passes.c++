@@ -0,0 +1,152 @@
+/*
+================================================================================
+VR MOD PASSES: per-HMD-frame render passes shared by both eyes (humbletim 2026)
+================================================================================
+
+Besides the eye view itself, each eye's `display()` regenerates the sun /
+moon shadow maps and the water reflection target. Neither changes
+meaningfully between two cameras a few centimetres apart, yet both were
+rendered twice per HMD frame.
+
+`0005-vrmod-shared-passes.patch` routes `gPipeline.generateSunShadow()` and
+`gPipeline.generateWaterReflection()` through `llviewerVR::RenderPass()`.
+With `vrmod.sharePasses` they run on the left eye pass only, and the right
+eye pass reuses their targets:
+
+-   **sun shadow:** the shadow maps are in world space, but the matrices
+    the deferred lighting uses to look them up (`mSunShadowMatrix`) start
+    from eye space. For the right eye they are rebased:
+    `shadow(right) = shadow(left) * view(left) * view(right)^-1`, with both
+    views built from the `LLViewerCamera` at the time of the pass.
+-   **water reflection:** reused as rendered for the left eye. It is
+    sampled in screen space, so reflections lose their own stereo depth and
+    sit at the water surface.
+
+Reflection probes are updated from inside the pipeline rather than from
+`display()`, and already spread their work over frames, so they are left
+alone.
+
+Each pass's GPU time (`GL_TIME_ELAPSED`) and CPU time, and how often it
+ran per HMD frame, are reported as `VRMOD: timing passes` when VR mode is
+left, shared or not.
+
+*/
+
+struct VrModPasses {
+    enum Pass { SUN_SHADOW, WATER_REFLECTION, PASS_COUNT };
+
+    VrModGpuTimer mGpuTimers[PASS_COUNT];
+    bool mRan[PASS_COUNT] = {};          // ran on this HMD frame's first pass
+    LLMatrix4a mLeftView;                // view at the first pass's sun shadow
+    std::vector<LLMatrix4a> mLeftShadow; // ...and the shadow matrices it produced
+
+    // runs render for this pass, or reuses the first eye pass's result
+    void run(Pass pass, std::function<void()> const& render, bool first_pass, bool stereo);
+
+    void release();
+
+private:
+    static LLMatrix4a viewMatrix(LLCamera const& camera);
+    static LLMatrix4a inverseRigid(LLMatrix4a const& view);
+    void saveShadowMatrices();
+    void rebaseShadowMatrices();
+};
+
+namespace {
+    // mSunShadowMatrix is glh::matrix4f or glm::mat4 depending on the viewer
+    // version; both are 16 column-major floats
+    const U32 VRMOD_SHADOW_MATRICES = sizeof(gPipeline.mSunShadowMatrix) / sizeof(gPipeline.mSunShadowMatrix[0]);
+    static_assert(sizeof(gPipeline.mSunShadowMatrix[0]) == sizeof(F32) * 16, "unexpected shadow matrix layout");
+    static_assert(VrModPasses::PASS_COUNT == VrModTelemetry::PASS_STATS, "pass telemetry out of step");
+
+    F32* shadow_matrix(U32 index) {
+        return reinterpret_cast<F32*>(&gPipeline.mSunShadowMatrix[index]);
+    }
+
+    // result = a * b (column-major)
+    LLMatrix4a mul(LLMatrix4a const& a, LLMatrix4a const& b) {
+        LLMatrix4a result;
+        for (S32 col = 0; col < 4; ++col) {
+            a.rotate4(b.mMatrix[col], result.mMatrix[col]);
+        }
+        return result;
+    }
+} // namespace
+
+void VrModPasses::run(Pass pass, std::function<void()> const& render, bool first_pass, bool stereo) {
+    mGpuTimers[pass].collect([pass](F64 seconds) { gVrModTelemetry.passGpuTimed(pass, seconds); });
+
+    if (!first_pass && mRan[pass] && gVrModSettings->sharePasses) {
+        if (pass == SUN_SHADOW) rebaseShadowMatrices();
+        gVrModTelemetry.passSkipped(pass);
+        return;
+    }
+
+    LLTimer timer;
+    mGpuTimers[pass].begin();
+    render();
+    mGpuTimers[pass].end();
+    gVrModTelemetry.passRan(pass, timer.getElapsedTimeF64());
+
+    mRan[pass] = first_pass && stereo;
+    if (mRan[pass] && pass == SUN_SHADOW) saveShadowMatrices();
+}
+
+void VrModPasses::release() {
+    for (auto& timer : mGpuTimers) timer.release();
+    std::fill(std::begin(mRan), std::end(mRan), false);
+}
+
+// GL view matrix of an LLCamera: x right (-left), y up, z back (-at)
+/*static*/ LLMatrix4a VrModPasses::viewMatrix(LLCamera const& camera) {
+    const LLVector3 o = camera.getOrigin();
+    const LLVector3 x = -camera.getLeftAxis();
+    const LLVector3 y = camera.getUpAxis();
+    const LLVector3 z = -camera.getAtAxis();
+    LLMatrix4a view;
+    view.mMatrix[0].set(x.mV[VX], y.mV[VX], z.mV[VX], 0.f);
+    view.mMatrix[1].set(x.mV[VY], y.mV[VY], z.mV[VY], 0.f);
+    view.mMatrix[2].set(x.mV[VZ], y.mV[VZ], z.mV[VZ], 0.f);
+    view.mMatrix[3].set(-(x * o), -(y * o), -(z * o), 1.f);
+    return view;
+}
+
+/*static*/ LLMatrix4a VrModPasses::inverseRigid(LLMatrix4a const& view) {
+    // transpose the rotation, rotate the negated translation back
+    LLMatrix4a inverse;
+    for (S32 col = 0; col < 3; ++col) {
+        inverse.mMatrix[col].set(view.mMatrix[0][col], view.mMatrix[1][col], view.mMatrix[2][col], 0.f);
+    }
+    const LLVector4a& t = view.mMatrix[3];
+    LLVector4a translation;
+    translation.set(-(t[0] * inverse.mMatrix[0][0] + t[1] * inverse.mMatrix[1][0] + t[2] * inverse.mMatrix[2][0]),
+                    -(t[0] * inverse.mMatrix[0][1] + t[1] * inverse.mMatrix[1][1] + t[2] * inverse.mMatrix[2][1]),
+                    -(t[0] * inverse.mMatrix[0][2] + t[1] * inverse.mMatrix[1][2] + t[2] * inverse.mMatrix[2][2]),
+                    1.f);
+    inverse.mMatrix[3] = translation;
+    return inverse;
+}
+
+void VrModPasses::saveShadowMatrices() {
+    mLeftView = viewMatrix(*LLViewerCamera::getInstance());
+    mLeftShadow.resize(VRMOD_SHADOW_MATRICES);
+    for (U32 i = 0; i < VRMOD_SHADOW_MATRICES; ++i) {
+        mLeftShadow[i].loadu(shadow_matrix(i));
+    }
+}
+
+void VrModPasses::rebaseShadowMatrices() {
+    const LLMatrix4a right_to_left = mul(mLeftView, inverseRigid(viewMatrix(*LLViewerCamera::getInstance())));
+    for (U32 i = 0; i < mLeftShadow.size(); ++i) {
+        const LLMatrix4a rebased = mul(mLeftShadow[i], right_to_left);
+        F32* out = shadow_matrix(i);
+        for (S32 col = 0; col < 4; ++col) {
+            for (S32 row = 0; row < 4; ++row) {
+                out[col * 4 + row] = rebased.mMatrix[col][row];
+            }
+        }
+    }
+}
+
+// Global instance, accessed from the main VR mod code.
+VrModPasses gVrModPasses;
@@ -0,0 +1,114 @@
+/*
+================================================================================
+VR MOD POINTER: controller clicks delivered straight to LLViewerWindow (humbletim 2026)
+================================================================================
+
+Controller trigger / grip presses used to be turned into OS mouse input:
+`setCursorPosition` to warp the desktop cursor, then `SendInput` for the
+button. Both round-trip through the OS input queue, so the click arrives a
+frame or more later, and neither works outside Windows.
+
+Now `RenderControllerAxes()` queues pointer events at the controller's
+projected coordinate. `vrDisplay()` hands them to LLViewerWindow's own mouse
+handlers (the same ones the platform window calls) once the eye pair is
+submitted, i.e. still within the frame that saw the press.
+
+-   Presses move the viewer's pointer to the controller first (like the old
+    cursor warp), except in mouselook, where they click in place.
+-   Releases happen wherever the pointer is.
+-   The pan-and-zoom regions in `vrDisplay()` follow the OS cursor. While a
+    controller is driving the pointer, `applyToCursor()` substitutes its
+    position, until the real mouse moves again.
+
+Each delivered press / release reports its queue-to-handler latency to the
+telemetry, summarized as `VRMOD: timing pointer` when VR mode is left.
+
+*/
+
+struct VrModPointer {
+    enum EventType { MOVE, LEFT_DOWN, LEFT_UP, RIGHT_DOWN, RIGHT_UP };
+
+    struct Event {
+        EventType type;
+        LLCoordWindow pos;  // scaled window coordinates, top-left origin
+        bool atCursor;      // ignore pos; use the viewer's current pointer
+        F64 queuedAt;
+    };
+
+    std::vector<Event> mQueue;
+    bool mDriving = false;     // the last pointer position came from a controller
+    LLCoordWindow mWindowPos;  // ...namely this one
+    LLCoordWindow mOsCursor;   // where the OS cursor was at that point
+
+    void push(EventType type, LLCoordWindow const& pos, bool at_cursor = false);
+
+    // delivers everything queued to gViewerWindow
+    void dispatch();
+
+    // drops anything queued (VR mode left)
+    void reset();
+
+    // substitutes the controller pointer for the OS cursor while it is driving
+    void applyToCursor(LLCoordWindow& os_cursor);
+};
+
+void VrModPointer::push(EventType type, LLCoordWindow const& pos, bool at_cursor) {
+    mQueue.push_back({ type, pos, at_cursor, LLTimer::getTotalSeconds() });
+}
+
+void VrModPointer::dispatch() {
+    if (mQueue.empty()) return;
+
+    LLWindow* window = gViewerWindow->getWindow();
+    const LLVector2& scale = gViewerWindow->getDisplayScale();
+    const S32 height = gViewerWindow->getWindowHeightScaled();
+    const MASK mask = gKeyboard->currentMask(TRUE);
+
+    for (auto const& event : mQueue) {
+        // LLViewerWindow's handlers take raw GL coordinates (bottom-left
+        // origin) and apply the display scale themselves
+        LLCoordGL pos;
+        if (event.atCursor) {
+            LLCoordGL current = gViewerWindow->getCurrentMouse();
+            pos.set(ll_round(current.mX * scale.mV[VX]), ll_round(current.mY * scale.mV[VY]));
+        } else {
+            pos.set(ll_round(event.pos.mX * scale.mV[VX]), ll_round((height - event.pos.mY) * scale.mV[VY]));
+            gViewerWindow->handleMouseMove(window, pos, mask);
+            mWindowPos = event.pos;
+            mDriving = true;
+        }
+
+        switch (event.type) {
+        case MOVE:       break;
+        case LEFT_DOWN:  gViewerWindow->handleMouseDown(window, pos, mask); break;
+        case LEFT_UP:    gViewerWindow->handleMouseUp(window, pos, mask); break;
+        case RIGHT_DOWN: gViewerWindow->handleRightMouseDown(window, pos, mask); break;
+        case RIGHT_UP:   gViewerWindow->handleRightMouseUp(window, pos, mask); break;
+        }
+        if (event.type != MOVE) {
+            gVrModTelemetry.pointerDelivered(LLTimer::getTotalSeconds() - event.queuedAt);
+        }
+    }
+    mQueue.clear();
+
+    if (mDriving) {
+        window->getCursorPosition(&mOsCursor);
+    }
+}
+
+void VrModPointer::reset() {
+    mQueue.clear();
+    mDriving = false;
+}
+
+void VrModPointer::applyToCursor(LLCoordWindow& os_cursor) {
+    if (!mDriving) return;
+    if (os_cursor.mX != mOsCursor.mX || os_cursor.mY != mOsCursor.mY) {
+        mDriving = false; // the mouse took over again
+        return;
+    }
+    os_cursor = mWindowPos;
+}
+
+// Global instance, accessed from the main VR mod code.
+VrModPointer gVrModPointer;
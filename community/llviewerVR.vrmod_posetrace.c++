@@ -0,0 +1,272 @@
+/*
+================================================================================
+VR MOD POSE TRACE: record and replay tracked device poses (humbletim 2026)
+================================================================================
+
+Performance problems in VR mode depend on how the head and hands move, and
+no two sessions move the same way. `vrmod.poseRecord` writes the poses
+`WaitGetPoses` returns each HMD frame to a trace file. `vrmod.poseReplay`
+feeds a trace back in place of the live poses, one recorded frame per HMD
+frame, so two builds or two settings can be compared over identical
+motion.
+
+`WaitGetPoses` is still called while replaying: it is what paces the
+viewer to the compositor. Only the poses it returns are replaced.
+Controller buttons are not part of the trace.
+
+Trace file (`logs/vrmod_poses.trace`), little-endian, append-only; a crash
+leaves a readable prefix, and the layout can be mmap'ed by external tools:
+
+    FileHeader   magic "VRMODPT1", version, sizeof(DeviceSample)
+    FrameHeader  seconds since the first frame, frame number, device count
+    DeviceSample device index, tracking result, flags,
+                 3x4 device-to-absolute matrix, velocity, angular velocity
+    (DeviceSample x count, then the next FrameHeader ...)
+
+All three are multiples of 8 bytes, so every FrameHeader's F64 stays
+naturally aligned in a mapping. Only devices with a connected or valid pose
+are written: an HMD and two controllers take 256 bytes per frame (~23 KB/s
+at 90 Hz).
+
+The replay loops at the end of the trace. Each pass over it is reported as
+`VRMOD: timing replay` with the frame interval average, 95th percentile
+and maximum, for A/B comparisons.
+
+*/
+
+#include <cstring>
+
+struct VrModPoseTrace {
+#pragma pack(push, 1)
+    struct FileHeader {
+        char magic[8];
+        U32 version;
+        U32 sampleSize;
+    };
+    struct FrameHeader {
+        F64 seconds;
+        U32 frame;
+        U16 count;
+        U16 reserved;
+    };
+    struct DeviceSample {
+        U8 device;
+        U8 trackingResult;  // vr::ETrackingResult
+        U8 flags;           // FLAG_*
+        U8 reserved;
+        F32 pose[3][4];
+        F32 velocity[3];
+        F32 angularVelocity[3];
+        U32 padding;        // 80 bytes: keeps the next FrameHeader 8-byte aligned
+    };
+#pragma pack(pop)
+    static_assert(sizeof(FileHeader) % 8 == 0 && sizeof(FrameHeader) % 8 == 0 && sizeof(DeviceSample) % 8 == 0,
+                  "trace records must keep FrameHeader::seconds 8-byte aligned");
+    enum { FLAG_VALID = 1, FLAG_CONNECTED = 2 };
+    static const U32 VERSION = 2;
+
+    // recording
+    llofstream mOut;
+    F64 mRecordStart = 0.0;
+    U32 mRecordFrames = 0;
+
+    // replay: the whole trace, and where each frame starts
+    std::vector<char> mTrace;
+    std::vector<size_t> mFrames;
+    size_t mNext = 0;
+    U32 mLoops = 0;
+    F64 mLastFrameAt = 0.0;
+    std::vector<F32> mIntervals;  // this loop's frame intervals (ms)
+
+    bool replaying() const { return !mFrames.empty(); }
+
+    // after WaitGetPoses: records poses, or overwrites them with the next
+    // replayed frame; starts / stops either as the settings change
+    void frame(vr::TrackedDevicePose_t* poses);
+
+    // VR mode left
+    void stop();
+
+private:
+    std::string path() const;
+    void startRecording();
+    void stopRecording();
+    void record(const vr::TrackedDevicePose_t* poses);
+    bool load();
+    void replay(vr::TrackedDevicePose_t* poses);
+    void reportLoop();
+};
+
+namespace {
+    const char VRMOD_POSE_TRACE_MAGIC[8] = { 'V', 'R', 'M', 'O', 'D', 'P', 'T', '1' };
+} // namespace
+
+std::string VrModPoseTrace::path() const {
+    return gDirUtilp->getExpandedFilename(LL_PATH_LOGS, "vrmod_poses.trace");
+}
+
+void VrModPoseTrace::frame(vr::TrackedDevicePose_t* poses) {
+    if (gVrModSettings->poseReplay) {
+        if (!replaying() && !load()) {
+            gSavedSettings.setBOOL("vrmod.poseReplay", FALSE);
+            return;
+        }
+        replay(poses);
+        return;
+    }
+    if (replaying()) {
+        reportLoop();
+        mTrace.clear();
+        mFrames.clear();
+    }
+
+    if (gVrModSettings->poseRecord != mOut.is_open()) {
+        if (mOut.is_open()) stopRecording(); else startRecording();
+    }
+    if (mOut.is_open()) record(poses);
+}
+
+void VrModPoseTrace::stop() {
+    if (mOut.is_open()) stopRecording();
+    if (replaying()) reportLoop();
+    mTrace.clear();
+    mFrames.clear();
+}
+
+void VrModPoseTrace::startRecording() {
+    mOut.open(path(), std::ios::binary | std::ios::trunc);
+    if (!mOut.is_open()) {
+        LL_WARNS() << "VRMOD: could not create " << path() << LL_ENDL;
+        gSavedSettings.setBOOL("vrmod.poseRecord", FALSE);
+        return;
+    }
+    FileHeader header;
+    memcpy(header.magic, VRMOD_POSE_TRACE_MAGIC, sizeof(header.magic));
+    header.version = VERSION;
+    header.sampleSize = sizeof(DeviceSample);
+    mOut.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    mRecordStart = LLTimer::getTotalSeconds();
+    mRecordFrames = 0;
+    LL_WARNS() << "VRMOD: recording poses to " << path() << LL_ENDL;
+}
+
+void VrModPoseTrace::stopRecording() {
+    mOut.close();
+    LL_WARNS() << "VRMOD: recorded " << mRecordFrames << " frames ("
+               << llformat("%.1f", LLTimer::getTotalSeconds() - mRecordStart) << " s) to " << path() << LL_ENDL;
+}
+
+void VrModPoseTrace::record(const vr::TrackedDevicePose_t* poses) {
+    DeviceSample samples[vr::k_unMaxTrackedDeviceCount];
+    U16 count = 0;
+    for (U32 device = 0; device < vr::k_unMaxTrackedDeviceCount; ++device) {
+        const vr::TrackedDevicePose_t& pose = poses[device];
+        if (!pose.bPoseIsValid && !pose.bDeviceIsConnected) continue;
+        DeviceSample& sample = samples[count++];
+        sample.device = (U8)device;
+        sample.trackingResult = (U8)pose.eTrackingResult;
+        sample.flags = (pose.bPoseIsValid ? FLAG_VALID : 0) | (pose.bDeviceIsConnected ? FLAG_CONNECTED : 0);
+        sample.reserved = 0;
+        sample.padding = 0;
+        memcpy(sample.pose, pose.mDeviceToAbsoluteTracking.m, sizeof(sample.pose));
+        memcpy(sample.velocity, pose.vVelocity.v, sizeof(sample.velocity));
+        memcpy(sample.angularVelocity, pose.vAngularVelocity.v, sizeof(sample.angularVelocity));
+    }
+    FrameHeader header = { LLTimer::getTotalSeconds() - mRecordStart, mRecordFrames++, count, 0 };
+    mOut.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    mOut.write(reinterpret_cast<const char*>(samples), sizeof(DeviceSample) * count);
+}
+
+bool VrModPoseTrace::load() {
+    llifstream in(path(), std::ios::binary);
+    if (!in.is_open()) {
+        LL_WARNS() << "VRMOD: no pose trace at " << path() << "; record one with vrmod.poseRecord first" << LL_ENDL;
+        return false;
+    }
+    mTrace.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+
+    FileHeader header;
+    if (mTrace.size() < sizeof(header)) {
+        mTrace.clear();
+        return false;
+    }
+    memcpy(&header, mTrace.data(), sizeof(header));
+    if (memcmp(header.magic, VRMOD_POSE_TRACE_MAGIC, sizeof(header.magic)) || header.version != VERSION
+        || header.sampleSize != sizeof(DeviceSample)) {
+        LL_WARNS() << "VRMOD: " << path() << " is not a version " << VERSION << " pose trace" << LL_ENDL;
+        mTrace.clear();
+        return false;
+    }
+
+    // index the frames; a truncated last frame (recording cut short) is dropped
+    mFrames.clear();
+    size_t offset = sizeof(header);
+    while (offset + sizeof(FrameHeader) <= mTrace.size()) {
+        FrameHeader frame;
+        memcpy(&frame, mTrace.data() + offset, sizeof(frame));
+        const size_t end = offset + sizeof(frame) + sizeof(DeviceSample) * frame.count;
+        if (end > mTrace.size()) break;
+        mFrames.push_back(offset);
+        offset = end;
+    }
+    if (mFrames.empty()) {
+        LL_WARNS() << "VRMOD: " << path() << " has no frames" << LL_ENDL;
+        mTrace.clear();
+        return false;
+    }
+    mNext = 0;
+    mLoops = 0;
+    mLastFrameAt = 0.0;
+    mIntervals.clear();
+    LL_WARNS() << "VRMOD: replaying " << mFrames.size() << " frames from " << path() << LL_ENDL;
+    return true;
+}
+
+void VrModPoseTrace::replay(vr::TrackedDevicePose_t* poses) {
+    const F64 now = LLTimer::getTotalSeconds();
+    if (mLastFrameAt > 0.0) mIntervals.push_back((F32)((now - mLastFrameAt) * 1000.0));
+    mLastFrameAt = now;
+
+    for (U32 device = 0; device < vr::k_unMaxTrackedDeviceCount; ++device) {
+        poses[device].bPoseIsValid = false;
+        poses[device].bDeviceIsConnected = false;
+    }
+    FrameHeader frame;
+    const char* data = mTrace.data() + mFrames[mNext];
+    memcpy(&frame, data, sizeof(frame));
+    data += sizeof(frame);
+    for (U16 i = 0; i < frame.count; ++i, data += sizeof(DeviceSample)) {
+        DeviceSample sample;
+        memcpy(&sample, data, sizeof(sample));
+        if (sample.device >= vr::k_unMaxTrackedDeviceCount) continue;
+        vr::TrackedDevicePose_t& pose = poses[sample.device];
+        pose.eTrackingResult = (vr::ETrackingResult)sample.trackingResult;
+        pose.bPoseIsValid = (sample.flags & FLAG_VALID) != 0;
+        pose.bDeviceIsConnected = (sample.flags & FLAG_CONNECTED) != 0;
+        memcpy(pose.mDeviceToAbsoluteTracking.m, sample.pose, sizeof(sample.pose));
+        memcpy(pose.vVelocity.v, sample.velocity, sizeof(sample.velocity));
+        memcpy(pose.vAngularVelocity.v, sample.angularVelocity, sizeof(sample.angularVelocity));
+    }
+
+    if (++mNext == mFrames.size()) {
+        reportLoop();
+        mNext = 0;
+        mLoops++;
+    }
+}
+
+void VrModPoseTrace::reportLoop() {
+    if (mIntervals.empty()) return;
+    std::vector<F32> sorted = mIntervals;
+    std::sort(sorted.begin(), sorted.end());
+    F64 sum = 0.0;
+    for (F32 interval : sorted) sum += interval;
+    LL_WARNS() << "VRMOD: timing replay pass " << (mLoops + 1) << " (" << mNext << "/" << mFrames.size() << " frames): "
+               << llformat("frame interval avg %.2f ms, p95 %.2f ms, max %.2f ms",
+                           sum / sorted.size(), sorted[(sorted.size() * 95) / 100], sorted.back())
+               << LL_ENDL;
+    mIntervals.clear();
+}
+
+// Global instance, accessed from the main VR mod code.
+VrModPoseTrace gVrModPoseTrace;
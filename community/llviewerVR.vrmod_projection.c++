@@ -0,0 +1,146 @@
+/*
+================================================================================
+VR MOD PROJECTION: controller ray endpoints to window coordinates (humbletim 2026)
+================================================================================
+
+The controller cursors need each ray endpoint in window coordinates. That
+used to be one `gluProject` per controller per render pass, each call first
+widening `gGLModelView` / `gGLProjection` into fresh F64 copies and
+multiplying both matrices again.
+
+Instead the view-projection product is formed once per pass in float
+(`update()`), and all endpoints are mapped in one loop (`project()`) using
+the viewer's SSE matrix type. Results match `gluProject` to the pixel except
+where a coordinate lands within float rounding of a pixel boundary.
+
+`vrmod.projectionCheck` runs `selfCheck()` on the next VR frame: random
+points around the camera are projected both ways, and the largest pixel
+difference plus the per-point cost of each path are logged as
+`VRMOD: projection check`.
+
+*/
+
+#include "llmatrix4a.h"
+#include "llrand.h"
+#include "llrender.h"
+
+struct VrModProjection {
+    LLMatrix4a mViewProj;  // gGLProjection * gGLModelView (column-major, like GL)
+    F32 mViewport[4];      // raw world view rect: left, bottom, width, height
+    F32 mInvScale[2];      // raw pixels -> scaled UI coordinates
+
+    // snapshots the current GL matrices and world view rect
+    void update();
+
+    // maps count agent-space points to window coordinates; points with
+    // w == 0 (where gluProject fails) come back as (-1, -1)
+    void project(const LLVector3* pos_agent, LLCoordGL* out_point, U32 count) const;
+
+    // compares project() against gluProject and times both
+    void selfCheck();
+};
+
+void VrModProjection::update() {
+    LLMatrix4a proj;
+    proj.loadu(gGLProjection);
+    for (S32 col = 0; col < 4; ++col) {
+        LLVector4a mdlv_col;
+        mdlv_col.loadua(gGLModelView + col * 4);
+        proj.rotate4(mdlv_col, mViewProj.mMatrix[col]);
+    }
+
+    LLRect world_view_rect = gViewerWindow->getWorldViewRectRaw();
+    mViewport[0] = (F32)world_view_rect.mLeft;
+    mViewport[1] = (F32)world_view_rect.mBottom;
+    mViewport[2] = (F32)world_view_rect.getWidth();
+    mViewport[3] = (F32)world_view_rect.getHeight();
+
+    mInvScale[0] = 1.f / gViewerWindow->getDisplayScale().mV[VX];
+    mInvScale[1] = 1.f / gViewerWindow->getDisplayScale().mV[VY];
+}
+
+void VrModProjection::project(const LLVector3* pos_agent, LLCoordGL* out_point, U32 count) const {
+    const F32 half_width = mViewport[2] * 0.5f;
+    const F32 half_height = mViewport[3] * 0.5f;
+    for (U32 i = 0; i < count; ++i) {
+        LLVector4a pos, clip;
+        pos.load3(pos_agent[i].mV, 1.f);
+        mViewProj.rotate4(pos, clip);
+        const F32 w = clip[3];
+        if (w == 0.f) {
+            out_point[i].set(-1, -1);
+            continue;
+        }
+        const F32 inv_w = 1.f / w;
+        const F32 x = mViewport[0] + half_width * (clip[0] * inv_w + 1.f);
+        const F32 y = mViewport[1] + half_height * (clip[1] * inv_w + 1.f);
+        out_point[i].set(lltrunc(x * mInvScale[0]), lltrunc(y * mInvScale[1]));
+    }
+}
+
+namespace {
+    // the former llviewerVR::posToScreen, kept as the reference
+    BOOL glu_pos_to_screen(const LLVector3& pos_agent, LLCoordGL& out_point) {
+        GLdouble x, y, z;
+        LLRect world_view_rect = gViewerWindow->getWorldViewRectRaw();
+        S32 viewport[4] = { world_view_rect.mLeft, world_view_rect.mBottom, world_view_rect.getWidth(), world_view_rect.getHeight() };
+        F64 mdlv[16];
+        F64 proj[16];
+        for (U32 i = 0; i < 16; i++) {
+            mdlv[i] = (F64)gGLModelView[i];
+            proj[i] = (F64)gGLProjection[i];
+        }
+        if (GL_TRUE != gluProject(pos_agent.mV[VX], pos_agent.mV[VY], pos_agent.mV[VZ], mdlv, proj, (GLint*)viewport, &x, &y, &z))
+            return FALSE;
+        x /= gViewerWindow->getDisplayScale().mV[VX];
+        y /= gViewerWindow->getDisplayScale().mV[VY];
+        out_point.set(lltrunc(x), lltrunc(y));
+        return TRUE;
+    }
+} // namespace
+
+void VrModProjection::selfCheck() {
+    const U32 COUNT = 1024;
+    const U32 ROUNDS = 50;
+
+    // the same spread the controller rays cover: within ~20m of the camera
+    std::vector<LLVector3> points(COUNT);
+    LLVector3 origin = LLViewerCamera::getInstance()->getOrigin();
+    for (auto& point : points) {
+        point = origin + LLVector3(ll_frand(40.f) - 20.f, ll_frand(40.f) - 20.f, ll_frand(40.f) - 20.f);
+    }
+
+    std::vector<LLCoordGL> batched(COUNT), reference(COUNT);
+    LLTimer timer;
+    for (U32 round = 0; round < ROUNDS; ++round) {
+        update();
+        project(points.data(), batched.data(), COUNT);
+    }
+    F64 batched_seconds = timer.getElapsedTimeF64();
+
+    timer.reset();
+    for (U32 round = 0; round < ROUNDS; ++round) {
+        for (U32 i = 0; i < COUNT; ++i) {
+            reference[i].set(-1, -1);
+            glu_pos_to_screen(points[i], reference[i]);
+        }
+    }
+    F64 glu_seconds = timer.getElapsedTimeF64();
+
+    S32 max_error = 0;
+    U32 off_by_more = 0;
+    for (U32 i = 0; i < COUNT; ++i) {
+        S32 error = llmax(llabs(batched[i].mX - reference[i].mX), llabs(batched[i].mY - reference[i].mY));
+        max_error = llmax(max_error, error);
+        if (error > 1) off_by_more++;
+    }
+
+    const F64 ns_per_point = 1.0e9 / (F64)(COUNT * ROUNDS);
+    LL_WARNS() << "VRMOD: projection check: max error " << max_error << " px over " << COUNT << " points"
+               << " (" << off_by_more << " off by more than 1 px); "
+               << llformat("batched %.1f ns/point, gluProject %.1f ns/point", batched_seconds * ns_per_point, glu_seconds * ns_per_point)
+               << LL_ENDL;
+}
+
+// Global instance, accessed from the main VR mod code.
+VrModProjection gVrModProjection;
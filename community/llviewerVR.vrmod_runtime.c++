@@ -0,0 +1,200 @@
+/*
+================================================================================
+VR MOD RUNTIME: the calls llviewerVR makes into the VR runtime (humbletim 2026)
+================================================================================
+
+llviewerVR used to talk to OpenVR directly: `VR_Init`, `WaitGetPoses`,
+`GetProjectionRaw`, `GetEyeToHeadTransform`, `Submit`, controller state and
+event polling were spread over the file. They now go through `VrModRuntime`.
+`VrModOpenVR` below is so far its only implementation, the calls as they
+were: the eye images are blitted into the mod's own resolve textures and
+handed to `IVRCompositor::Submit`.
+
+The interface covers what llviewerVR needs today and nothing more. A second
+runtime (OpenXR, say) would extend it with whatever it needs -- its own
+swapchain images, a session that comes up over several frames -- together
+with a setting to choose it.
+
+OpenVR types stay the lingua franca: poses are `vr::TrackedDevicePose_t`
+(device 0 is the head), projections are `GetProjectionRaw` tangents, eye
+offsets `HmdMatrix34_t`, so the rest of the mod is unchanged. The SteamVR
+overlay UI panel (VR MOD OVERLAY) and render models remain OpenVR-only.
+
+Startup is still split as before: `init()` runs on the startup worker,
+`start()` on the render thread once the worker is done (for what needs the
+viewer's GL context current).
+
+*/
+
+struct VrModRuntime {
+    struct Info {
+        std::string driver;
+        std::string display;
+        U32 width = 0, height = 0;  // recommended per-eye render size
+        // OpenVR only (overlay, render models)
+        vr::IVRSystem* hmd = NULL;
+        vr::IVRRenderModels* renderModels = NULL;
+    };
+
+    virtual ~VrModRuntime() {}
+    virtual const char* name() const = 0;
+
+    // startup worker: loads the runtime and queries the headset; stage
+    // follows llviewerVR::StartupStage
+    virtual bool init(Info& info, std::string& error, std::atomic<S32>& stage) = 0;
+
+    // render thread, after init: creates what needs the GL context
+    virtual bool start(std::string& error) = 0;
+
+    virtual void shutdown() = 0;
+
+    // once per HMD frame, after submit: paces to the display and fills the
+    // predicted poses (index vr::k_unTrackedDeviceIndex_Hmd is the head)
+    virtual void waitFrame(vr::TrackedDevicePose_t* poses) = 0;
+
+    virtual vr::ETrackedDeviceClass deviceClass(vr::TrackedDeviceIndex_t device) = 0;
+    virtual bool deviceConnected(vr::TrackedDeviceIndex_t device) = 0;
+    virtual bool inputAvailable() = 0;
+    virtual bool controllerActions(vr::TrackedDeviceIndex_t device, VrModInput::ControllerActions& out) = 0;
+
+    // delivers runtime events in their OpenVR form; runtimes without
+    // OpenVR events handle their own
+    virtual void pollEvents(std::function<void(vr::VREvent_t const&)> const& handler) = 0;
+
+    // tangents of the eye frustum's sides in IVRSystem::GetProjectionRaw
+    // order; its "top" is the lower edge (negative), "bottom" the upper one
+    virtual void projectionRaw(vr::Hmd_Eye eye, F32* left, F32* right, F32* top, F32* bottom) = 0;
+    virtual vr::HmdMatrix44_t projectionMatrix(vr::Hmd_Eye eye, F32 near_clip, F32 far_clip);
+    virtual vr::HmdMatrix34_t eyeToHead(vr::Hmd_Eye eye) = 0;
+    virtual F32 displayFrequency() = 0;
+
+    // hands this frame's eye images to the compositor
+    virtual void submit(GLuint left_texture, GLuint right_texture) = 0;
+};
+
+// as IVRSystem::GetProjectionMatrix composes it from the raw tangents
+vr::HmdMatrix44_t VrModRuntime::projectionMatrix(vr::Hmd_Eye eye, F32 near_clip, F32 far_clip) {
+    F32 left, right, top, bottom;
+    projectionRaw(eye, &left, &right, &top, &bottom);
+    const F32 idx = 1.f / (right - left);
+    const F32 idy = 1.f / (bottom - top);
+    const F32 idz = 1.f / (far_clip - near_clip);
+    vr::HmdMatrix44_t mat = {{
+        { 2.f * idx, 0.f,       (right + left) * idx, 0.f },
+        { 0.f,       2.f * idy, (bottom + top) * idy, 0.f },
+        { 0.f,       0.f,       -far_clip * idz,      -far_clip * near_clip * idz },
+        { 0.f,       0.f,       -1.f,                 0.f },
+    }};
+    return mat;
+}
+
+struct VrModOpenVR : VrModRuntime {
+    vr::IVRSystem* mSystem = NULL;
+
+    const char* name() const override { return "OpenVR"; }
+    bool init(Info& info, std::string& error, std::atomic<S32>& stage) override;
+    bool start(std::string& error) override;
+    void shutdown() override;
+    void waitFrame(vr::TrackedDevicePose_t* poses) override;
+    vr::ETrackedDeviceClass deviceClass(vr::TrackedDeviceIndex_t device) override { return mSystem->GetTrackedDeviceClass(device); }
+    bool deviceConnected(vr::TrackedDeviceIndex_t device) override { return mSystem->IsTrackedDeviceConnected(device); }
+    bool inputAvailable() override { return mSystem->IsInputAvailable(); }
+    bool controllerActions(vr::TrackedDeviceIndex_t device, VrModInput::ControllerActions& out) override;
+    void pollEvents(std::function<void(vr::VREvent_t const&)> const& handler) override;
+    void projectionRaw(vr::Hmd_Eye eye, F32* left, F32* right, F32* top, F32* bottom) override;
+    vr::HmdMatrix44_t projectionMatrix(vr::Hmd_Eye eye, F32 near_clip, F32 far_clip) override;
+    vr::HmdMatrix34_t eyeToHead(vr::Hmd_Eye eye) override { return mSystem->GetEyeToHeadTransform(eye); }
+    F32 displayFrequency() override;
+    void submit(GLuint left_texture, GLuint right_texture) override;
+};
+
+namespace {
+    std::string tracked_device_string(vr::IVRSystem* hmd, vr::TrackedDeviceIndex_t device, vr::TrackedDeviceProperty prop) {
+        char buf[vr::k_unMaxPropertyStringSize];
+        return hmd->GetStringTrackedDeviceProperty(device, prop, buf, sizeof(buf)) ? buf : "";
+    }
+} // namespace
+
+bool VrModOpenVR::init(Info& info, std::string& error, std::atomic<S32>& stage) {
+    char buf[1024];
+    vr::EVRInitError eError = vr::VRInitError_None;
+    vr::IVRSystem* hmd = vr::VR_Init(&eError, vr::VRApplication_Scene);
+    if (eError != vr::VRInitError_None) {
+        sprintf_s(buf, sizeof(buf), "\nERROR Unable to init VR runtime: %s", vr::VR_GetVRInitErrorAsEnglishDescription(eError));
+        error = buf;
+        // the runtime may have moved or been (re)installed; look again next time
+        openvr_api::discardRuntimePaths();
+        return false;
+    }
+
+    stage = llviewerVR::STARTUP_ACQUIRING_INTERFACES;
+    eError = vr::VRInitError_None;
+    info.renderModels = (vr::IVRRenderModels*)vr::VR_GetGenericInterface(vr::IVRRenderModels_Version, &eError);
+    if (!info.renderModels) {
+        sprintf_s(buf, sizeof(buf), "\nERROR Unable to get render model interface: %s", vr::VR_GetVRInitErrorAsEnglishDescription(eError));
+        error = buf;
+        vr::VR_Shutdown();
+        return false;
+    }
+    if (!vr::VRCompositor()) {
+        error = "\nERROR No compositor interface";
+        info.renderModels = NULL;
+        vr::VR_Shutdown();
+        return false;
+    }
+
+    stage = llviewerVR::STARTUP_QUERYING_DEVICE;
+    mSystem = info.hmd = hmd;
+    info.driver = tracked_device_string(hmd, vr::k_unTrackedDeviceIndex_Hmd, vr::Prop_TrackingSystemName_String);
+    info.display = tracked_device_string(hmd, vr::k_unTrackedDeviceIndex_Hmd, vr::Prop_SerialNumber_String);
+    hmd->GetRecommendedRenderTargetSize(&info.width, &info.height);
+    gVrModInput.init();
+    return true;
+}
+
+bool VrModOpenVR::start(std::string& error) {
+    vr::VRCompositor()->SetTrackingSpace(vr::TrackingUniverseSeated);
+    return true;
+}
+
+void VrModOpenVR::shutdown() {
+    vr::VR_Shutdown();
+    mSystem = NULL;
+}
+
+void VrModOpenVR::waitFrame(vr::TrackedDevicePose_t* poses) {
+    vr::VRCompositor()->WaitGetPoses(poses, vr::k_unMaxTrackedDeviceCount, NULL, 0);
+}
+
+bool VrModOpenVR::controllerActions(vr::TrackedDeviceIndex_t device, VrModInput::ControllerActions& out) {
+    return gVrModInput.get(mSystem, device, out);
+}
+
+void VrModOpenVR::pollEvents(std::function<void(vr::VREvent_t const&)> const& handler) {
+    vr::VREvent_t event;
+    while (mSystem && mSystem->PollNextEvent(&event, sizeof(event))) {
+        handler(event);
+    }
+}
+
+void VrModOpenVR::projectionRaw(vr::Hmd_Eye eye, F32* left, F32* right, F32* top, F32* bottom) {
+    mSystem->GetProjectionRaw(eye, left, right, top, bottom);
+}
+
+vr::HmdMatrix44_t VrModOpenVR::projectionMatrix(vr::Hmd_Eye eye, F32 near_clip, F32 far_clip) {
+    return mSystem->GetProjectionMatrix(eye, near_clip, far_clip);
+}
+
+F32 VrModOpenVR::displayFrequency() {
+    return mSystem->GetFloatTrackedDeviceProperty(vr::k_unTrackedDeviceIndex_Hmd, vr::Prop_DisplayFrequency_Float);
+}
+
+void VrModOpenVR::submit(GLuint left_texture, GLuint right_texture) {
+    vr::Texture_t left = { (void*)(uintptr_t)left_texture, vr::TextureType_OpenGL, vr::ColorSpace_Gamma };
+    vr::Texture_t right = { (void*)(uintptr_t)right_texture, vr::TextureType_OpenGL, vr::ColorSpace_Gamma };
+    vr::VRCompositor()->Submit(vr::Eye_Left, &left, 0, vr::Submit_Default);
+    vr::VRCompositor()->Submit(vr::Eye_Right, &right, 0, vr::Submit_Default);
+}
+
+// Global instance, accessed from the main VR mod code.
+VrModOpenVR gVrModOpenVR;
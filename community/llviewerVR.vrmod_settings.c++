@@ -80,6 +80,80 @@ struct VrModSettings {
         "0.001 is a good value to try using; 0.015 is a good compromise to avoid z-fighting.\n"
         "Note: When VR Mode is active, this setting can be changed live to test the effect of different near clipping thresholds."
     };
+    LLCachedControl<bool> discoverAtStartup{ gSavedSettings, "vrmod.discoverAtStartup", DEFAULTS.at("discoverAtStartup").as_bool(),
+        "Locate the OpenVR runtime (openvrpaths.vrpath) on a background thread at viewer startup, "
+        "so the first Ctrl+TAB does not have to. Takes effect on the next launch."
+    };
+    LLCachedControl<bool> projectionCheck{ gSavedSettings, "vrmod.projectionCheck", DEFAULTS.at("projectionCheck").as_bool(),
+        "Set while in VR mode to compare the batched controller-to-screen projection against gluProject "
+        "once (accuracy and cost per point are written to the log). Resets itself afterwards."
+    };
+    LLCachedControl<bool> legacyInput{ gSavedSettings, "vrmod.legacyInput", DEFAULTS.at("legacyInput").as_bool(),
+        "Read the hand controllers with the old per-device GetControllerState polling instead of "
+        "SteamVR Input actions (rebindable in the SteamVR bindings UI). Can be toggled live for comparison."
+    };
+    LLCachedControl<bool> uiOncePerFrame{ gSavedSettings, "vrmod.uiOncePerFrame", DEFAULTS.at("uiOncePerFrame").as_bool(),
+        "Draw the 2D UI once per HMD frame into a cached layer shared by both eyes, instead of once per eye. "
+        "Can be toggled live; UI cost per frame is written to the log when leaving VR mode."
+    };
+    LLCachedControl<F32>  uiMaxAge{ gSavedSettings, "vrmod.uiMaxAge", DEFAULTS.at("uiMaxAge").to_number<float>(),
+        "Experimental: with vrmod.uiOncePerFrame, keep the cached UI layer across HMD frames and redraw it only when "
+        "the pointer, focus, floaters or focused text field change, and otherwise at most this many seconds apart. "
+        "Changes it does not track (incoming chat, animations, the text caret) show up that late. "
+        "0.0 (default) redraws it every HMD frame."
+    };
+    LLCachedControl<bool> uiOverlay{ gSavedSettings, "vrmod.uiOverlay", DEFAULTS.at("uiOverlay").as_bool(),
+        "Show the 2D UI as a SteamVR overlay panel in front of you (usable with the SteamVR laser mouse) "
+        "instead of drawing it into the world view with the mouse pan-and-zoom regions. Can be toggled live."
+    };
+    LLCachedControl<F32>  uiOverlayDistance{ gSavedSettings, "vrmod.uiOverlayDistance", DEFAULTS.at("uiOverlayDistance").to_number<float>(),
+        "Distance in metres from the seated origin to the vrmod.uiOverlay panel."
+    };
+    LLCachedControl<F32>  uiOverlayWidth{ gSavedSettings, "vrmod.uiOverlayWidth", DEFAULTS.at("uiOverlayWidth").to_number<float>(),
+        "Width in metres of the vrmod.uiOverlay panel."
+    };
+    LLCachedControl<F32>  farFieldSplit{ gSavedSettings, "vrmod.farFieldSplit", DEFAULTS.at("farFieldSplit").to_number<float>(),
+        "Experimental: set to a distance in metres to render the scene beyond it once per HMD frame from between the eyes, "
+        "and only the nearer part per eye (0 = off). The log's 'stereo disparity drops below 1 px beyond' line suggests a value. "
+        "Can be changed live; GPU time per HMD frame with and without the split is written to the log when leaving VR mode."
+    };
+    LLCachedControl<bool> sharedCull{ gSavedSettings, "vrmod.sharedCull", DEFAULTS.at("sharedCull").as_bool(),
+        "Experimental: cull once per HMD frame against a frustum enclosing both eyes, and let the right eye "
+        "reuse the left eye's visible set. Can be toggled live; cull cost is written to the log when leaving VR mode."
+    };
+    LLCachedControl<bool> sharePasses{ gSavedSettings, "vrmod.sharePasses", DEFAULTS.at("sharePasses").as_bool(),
+        "Render the sun/moon shadow maps and the water reflection once per HMD frame (left eye) and reuse them "
+        "for the right eye. Can be toggled live; per-pass GPU time is written to the log when leaving VR mode."
+    };
+    LLCachedControl<bool> poseRecord{ gSavedSettings, "vrmod.poseRecord", DEFAULTS.at("poseRecord").as_bool(),
+        "While set in VR mode, record the head and controller poses of every frame to logs/vrmod_poses.trace "
+        "(replaces the previous trace)."
+    };
+    LLCachedControl<bool> poseReplay{ gSavedSettings, "vrmod.poseReplay", DEFAULTS.at("poseReplay").as_bool(),
+        "While set in VR mode, replay logs/vrmod_poses.trace in a loop instead of the live head and controller poses; "
+        "frame timing of each pass over the trace is written to the log."
+    };
+    LLCachedControl<bool> capture{ gSavedSettings, "vrmod.capture", DEFAULTS.at("capture").as_bool(),
+        "While set in VR mode, read back the submitted eye images without stalling and write them to logs/vrmod_capture/; "
+        "images with a same-named file in logs/vrmod_capture/reference/ are compared against it in the log."
+    };
+    LLCachedControl<F32>  captureEvery{ gSavedSettings, "vrmod.captureEvery", DEFAULTS.at("captureEvery").to_number<float>(),
+        "Capture one eye pair every N HMD frames (1 = every frame; busy readbacks are dropped, never waited for)."
+    };
+    LLCachedControl<std::string> captureFormat{ gSavedSettings, "vrmod.captureFormat", DEFAULTS.at("captureFormat").as_string().c_str(),
+        "Capture file format: qoi (fast, lossless), png, or raw (RGBA bytes, size in the file name)."
+    };
+    LLCachedControl<bool> hitchDumps{ gSavedSettings, "vrmod.hitchDumps", DEFAULTS.at("hitchDumps").as_bool(),
+        "When an HMD frame misses its budget in VR mode, write the per-stage timings of the last 120 frames, "
+        "the tracked devices and these settings to logs/vrmod_hitch_<n>.txt (attach them to stutter reports)."
+    };
+    LLCachedControl<F32>  hitchThreshold{ gSavedSettings, "vrmod.hitchThreshold", DEFAULTS.at("hitchThreshold").to_number<float>(),
+        "A frame counts as a hitch when its interval exceeds this many HMD frame budgets (1 / display refresh rate); "
+        "1.5 catches a single missed vsync."
+    };
+    LLCachedControl<F32>  hitchDumpInterval{ gSavedSettings, "vrmod.hitchDumpInterval", DEFAULTS.at("hitchDumpInterval").to_number<float>(),
+        "Minimum seconds between two vrmod.hitchDumps files; hitches in between are only counted."
+    };
 
     // Updates a single property within the persisted JSON blob.
     void updateJsonEntry(std::string const& key, LLSD const& newValue);
@@ -98,6 +172,25 @@ struct VrModSettings {
     { "mousecursor",     true },
     { "cameraAngle",     0.0f },
     { "nearClip",        0.0f },
+    { "discoverAtStartup", true },
+    { "projectionCheck", false },
+    { "legacyInput",     false },
+    { "uiOncePerFrame",  true },
+    { "uiMaxAge",        0.0f },
+    { "uiOverlay",       false },
+    { "uiOverlayDistance", 1.5f },
+    { "uiOverlayWidth",  1.6f },
+    { "farFieldSplit",   0.0f },
+    { "sharedCull",      false },
+    { "sharePasses",     false },
+    { "poseRecord",      false },
+    { "poseReplay",      false },
+    { "capture",         false },
+    { "captureEvery",    90.0f },
+    { "captureFormat",   "qoi" },
+    { "hitchDumps",      true },
+    { "hitchThreshold",  1.5f },
+    { "hitchDumpInterval", 30.0f },
 };
 
 namespace {
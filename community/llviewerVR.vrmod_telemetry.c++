@@ -0,0 +1,352 @@
+/*
+================================================================================
+VR MOD TELEMETRY: frame-timing log (humbletim 2026)
+================================================================================
+
+Timing markers for the VR mode lifecycle, reported as `VRMOD:` lines in the
+regular viewer log so before/after comparisons can be made from any session
+(search the log for "VRMOD: timing").
+
+-   **startup:** how long VR startup (Ctrl+TAB) held the render thread --
+    launching the startup worker plus creating the eye framebuffers once it
+    is done -- i.e. the hitch, next to how long the worker itself took.
+-   **first frame:** from entering VR mode (TAB) to the first eye pair
+    submitted to the compositor.
+-   **pointer:** controller press / release to LLViewerWindow handler
+    latency, summarized when VR mode is left.
+-   **input:** time spent reading controller state per submitted frame,
+    split by IVRInput actions vs legacy polling (also on leaving VR mode).
+-   **ui:** CPU and GPU time of the 2D UI per submitted frame, and how often
+    it was actually drawn (per frame and per second), cached layer vs per
+    eye (on leaving VR mode).
+
+-   **cull:** time in `updateCull()` per submitted frame and the average
+    visible groups / drawables per cull, shared vs per eye (on leaving VR
+    mode).
+-   **passes:** GPU / CPU time of the per-HMD-frame passes (sun shadow,
+    water reflection) per submitted frame, and how often each ran, shared vs
+    per eye (on leaving VR mode).
+-   **stereo:** the distance beyond which the two eye views differ by less
+    than a pixel on this headset (IPD x focal length in pixels), logged once
+    the eye framebuffers exist. Everything past it is rendered twice for no
+    visible depth; it bounds what a mono far-field split could save.
+-   **farfield:** GPU time per HMD frame from its first pass to the end of
+    its eye passes, with the `vrmod.farFieldSplit` far pass (split into far
+    pass and eye passes) and without it (on leaving VR mode).
+
+Each startup line also notes whether the OpenVR runtime paths were answered
+from openvr_api's discovery cache or had to be read from
+`openvrpaths.vrpath`, and how long that read took.
+
+*/
+
+#include "lltimer.h"
+
+// GPU time of a stretch of GL commands: GL_TIME_ELAPSED queries from a small
+// ring, read back once available. A begin() whose ring slot is still in
+// flight goes untimed rather than waiting on the GPU. Timers must not nest.
+struct VrModGpuTimer {
+    static const U32 QUERY_COUNT = 8;
+
+    GLuint mQueries[QUERY_COUNT] = {};
+    bool mPending[QUERY_COUNT] = {};
+    U32 mNext = 0;
+    S32 mActive = -1;
+
+    void begin();
+    void end();
+
+    // hands every finished measurement (seconds) to sink
+    void collect(std::function<void(F64)> const& sink);
+
+    void release();
+};
+
+void VrModGpuTimer::begin() {
+    if (!mQueries[0]) glGenQueries(QUERY_COUNT, mQueries);
+    const U32 slot = mNext % QUERY_COUNT;
+    if (mPending[slot]) return;
+    glBeginQuery(GL_TIME_ELAPSED, mQueries[slot]);
+    mNext++;
+    mActive = (S32)slot;
+}
+
+void VrModGpuTimer::end() {
+    if (mActive < 0) return;
+    glEndQuery(GL_TIME_ELAPSED);
+    mPending[mActive] = true;
+    mActive = -1;
+}
+
+void VrModGpuTimer::collect(std::function<void(F64)> const& sink) {
+    for (U32 slot = 0; slot < QUERY_COUNT; ++slot) {
+        if (!mPending[slot]) continue;
+        GLuint available = 0;
+        glGetQueryObjectuiv(mQueries[slot], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) continue;
+        GLuint64 nanoseconds = 0;
+        glGetQueryObjectui64v(mQueries[slot], GL_QUERY_RESULT, &nanoseconds);
+        mPending[slot] = false;
+        sink((F64)nanoseconds * 1.0e-9);
+    }
+}
+
+void VrModGpuTimer::release() {
+    if (!mQueries[0]) return;
+    glDeleteQueries(QUERY_COUNT, mQueries);
+    std::fill(std::begin(mQueries), std::end(mQueries), 0);
+    std::fill(std::begin(mPending), std::end(mPending), false);
+    mActive = -1;
+}
+
+struct VrModTelemetry {
+    F64 mStartupBegin = 0.0;
+    F64 mStartupRenderSeconds = 0.0; // render-thread share of startup (the hitch)
+    F64 mActivatedAt = 0.0;
+    bool mAwaitingFirstFrame = false;
+    U32 mPointerEvents = 0;
+    F64 mPointerLatencySum = 0.0;
+    F64 mPointerLatencyMax = 0.0;
+    U32 mFrames = 0;              // eye pairs submitted since VR mode was entered
+    F64 mInputSeconds[2] = {};    // [0] IVRInput actions, [1] legacy GetControllerState
+    U32 mUiPasses = 0;            // render passes that drew or composited the 2D UI
+    U32 mUiDraws = 0;             // ...of which actually drew it
+    F64 mUiCpuSeconds = 0.0;
+    F64 mUiGpuSeconds = 0.0;      // summed over mUiGpuSamples timed passes
+    U32 mUiGpuSamples = 0;
+    struct FarFieldStats {
+        U32 frames = 0;         // timed HMD frames
+        F64 farSeconds = 0.0;   // GPU, far pass
+        F64 eyeSeconds = 0.0;   // GPU, eye passes
+    };
+    FarFieldStats mFarField[2];  // [0] without the split, [1] with it
+    U32 mCulls = 0;
+    U32 mCullsSkipped = 0;        // second eye passes that reused the first's visible set
+    F64 mCullSeconds = 0.0;
+    U64 mCullGroups = 0;          // summed over mCulls
+    U64 mCullDrawables = 0;
+    struct PassStats {
+        U32 runs = 0;
+        U32 skipped = 0;
+        F64 cpuSeconds = 0.0;
+        F64 gpuSeconds = 0.0;  // summed over gpuSamples timed runs
+        U32 gpuSamples = 0;
+    };
+    static const S32 PASS_STATS = 2;  // VrModPasses::PASS_COUNT, in its order
+    static constexpr const char* PASS_NAMES[PASS_STATS] = { "sun shadow", "water reflection" };
+    PassStats mPasses[PASS_STATS];
+    openvr_api::RuntimePathsStats mPathsBefore;
+
+    // bracket the render-thread parts of VR startup: launching the worker
+    // (startupBegin .. startupKicked) and finishing up (finishBegin .. startupEnd)
+    void startupBegin();
+    void startupKicked();
+    void finishBegin();
+    void startupEnd(bool initialized, F64 workerSeconds);
+
+    // headset geometry known (after SetupCameras)
+    void stereoGeometry(F32 ipdMeters, F32 focalPixels);
+
+    // VR mode entered (TAB); the next submitted eye pair ends the measurement
+    void activated();
+    void frameSubmitted();
+
+    // one controller button event handed to LLViewerWindow
+    void pointerDelivered(F64 latency);
+
+    // time spent reading controller state (one device, or the frame's
+    // UpdateActionState)
+    void inputPolled(F64 seconds, bool legacy);
+
+    // one render pass of the 2D UI (drawn, or the cached layer composited),
+    // and the GPU time of a pass once its query result is available
+    void uiRendered(F64 seconds, bool drawn);
+    void uiGpuTimed(F64 seconds);
+
+    // GPU time of a timed HMD frame (VR MOD FAR FIELD), with or without the
+    // far pass
+    void farFieldTimed(bool split, F64 farSeconds, F64 eyeSeconds);
+
+    // one updateCull() and what it found visible, or a pass that skipped it
+    void culled(F64 seconds, U32 groups, U32 drawables);
+    void cullSkipped();
+
+    // a per-HMD-frame pass (VrModPasses::Pass) that ran, was reused from the
+    // first eye pass, or whose GPU time came back
+    void passRan(S32 pass, F64 seconds);
+    void passSkipped(S32 pass);
+    void passGpuTimed(S32 pass, F64 seconds);
+
+    // VR mode left (TAB); reports the session's pointer latency
+    void deactivated();
+};
+
+void VrModTelemetry::startupBegin() {
+    mPathsBefore = openvr_api::runtimePathsStats();
+    mStartupBegin = LLTimer::getTotalSeconds();
+}
+
+void VrModTelemetry::startupKicked() {
+    mStartupRenderSeconds = LLTimer::getTotalSeconds() - mStartupBegin;
+}
+
+void VrModTelemetry::finishBegin() {
+    mStartupBegin = LLTimer::getTotalSeconds();
+}
+
+void VrModTelemetry::startupEnd(bool initialized, F64 workerSeconds) {
+    mStartupRenderSeconds += LLTimer::getTotalSeconds() - mStartupBegin;
+    auto paths = openvr_api::runtimePathsStats();
+    std::string discovery = paths.reads > mPathsBefore.reads
+        ? llformat("read in %.1f ms", paths.readSeconds * 1000.0)
+        : paths.hits > mPathsBefore.hits ? std::string("cached") : std::string("not reached");
+    LL_WARNS() << "VRMOD: timing startup hitch " << llformat("%.1f", mStartupRenderSeconds * 1000.0) << " ms"
+               << " (worker " << llformat("%.1f", workerSeconds * 1000.0) << " ms)"
+               << (initialized ? "" : " (failed)")
+               << "; runtime paths " << discovery << LL_ENDL;
+}
+
+void VrModTelemetry::stereoGeometry(F32 ipdMeters, F32 focalPixels) {
+    // disparity in pixels at distance d is ipd * focal / d
+    LL_WARNS() << "VRMOD: stereo disparity drops below 1 px beyond "
+               << llformat("%.0f m (IPD %.1f mm, focal length %.0f px)", ipdMeters * focalPixels, ipdMeters * 1000.f, focalPixels)
+               << LL_ENDL;
+}
+
+void VrModTelemetry::activated() {
+    mActivatedAt = LLTimer::getTotalSeconds();
+    mAwaitingFirstFrame = true;
+    mFrames = 0;
+    mInputSeconds[0] = mInputSeconds[1] = 0.0;
+    mUiPasses = mUiDraws = mUiGpuSamples = 0;
+    mUiCpuSeconds = mUiGpuSeconds = 0.0;
+    std::fill(std::begin(mFarField), std::end(mFarField), FarFieldStats());
+    mCulls = mCullsSkipped = 0;
+    mCullSeconds = 0.0;
+    mCullGroups = mCullDrawables = 0;
+    std::fill(std::begin(mPasses), std::end(mPasses), PassStats());
+}
+
+void VrModTelemetry::frameSubmitted() {
+    mFrames++;
+    if (!mAwaitingFirstFrame) return;
+    mAwaitingFirstFrame = false;
+    LL_WARNS() << "VRMOD: timing first frame "
+               << llformat("%.1f", (LLTimer::getTotalSeconds() - mActivatedAt) * 1000.0)
+               << " ms after entering VR mode" << LL_ENDL;
+}
+
+void VrModTelemetry::pointerDelivered(F64 latency) {
+    mPointerEvents++;
+    mPointerLatencySum += latency;
+    mPointerLatencyMax = llmax(mPointerLatencyMax, latency);
+}
+
+void VrModTelemetry::inputPolled(F64 seconds, bool legacy) {
+    mInputSeconds[legacy ? 1 : 0] += seconds;
+}
+
+void VrModTelemetry::uiRendered(F64 seconds, bool drawn) {
+    mUiPasses++;
+    if (drawn) mUiDraws++;
+    mUiCpuSeconds += seconds;
+}
+
+void VrModTelemetry::uiGpuTimed(F64 seconds) {
+    mUiGpuSeconds += seconds;
+    mUiGpuSamples++;
+}
+
+void VrModTelemetry::farFieldTimed(bool split, F64 farSeconds, F64 eyeSeconds) {
+    FarFieldStats& stats = mFarField[split ? 1 : 0];
+    stats.frames++;
+    stats.farSeconds += farSeconds;
+    stats.eyeSeconds += eyeSeconds;
+}
+
+void VrModTelemetry::culled(F64 seconds, U32 groups, U32 drawables) {
+    mCulls++;
+    mCullSeconds += seconds;
+    mCullGroups += groups;
+    mCullDrawables += drawables;
+}
+
+void VrModTelemetry::cullSkipped() {
+    mCullsSkipped++;
+}
+
+void VrModTelemetry::passRan(S32 pass, F64 seconds) {
+    mPasses[pass].runs++;
+    mPasses[pass].cpuSeconds += seconds;
+}
+
+void VrModTelemetry::passSkipped(S32 pass) {
+    mPasses[pass].skipped++;
+}
+
+void VrModTelemetry::passGpuTimed(S32 pass, F64 seconds) {
+    mPasses[pass].gpuSeconds += seconds;
+    mPasses[pass].gpuSamples++;
+}
+
+void VrModTelemetry::deactivated() {
+    mAwaitingFirstFrame = false;
+    if (mFrames) {
+        LL_WARNS() << "VRMOD: timing input over " << mFrames << " frames: "
+                   << llformat("actions %.1f us/frame, legacy polling %.1f us/frame",
+                               mInputSeconds[0] / mFrames * 1.0e6, mInputSeconds[1] / mFrames * 1.0e6)
+                   << LL_ENDL;
+    }
+    if (mFrames && mUiPasses) {
+        // GPU time is sampled per pass; scale the average pass to a frame
+        const F64 passes_per_frame = (F64)mUiPasses / mFrames;
+        const F64 gpu_per_frame = mUiGpuSamples ? mUiGpuSeconds / mUiGpuSamples * passes_per_frame : 0.0;
+        const F64 seconds = llmax(LLTimer::getTotalSeconds() - mActivatedAt, 0.001);
+        LL_WARNS() << "VRMOD: timing ui over " << mFrames << " frames ("
+                   << (gVrModSettings->uiOncePerFrame ? "cached layer" : "per eye") << "): "
+                   << llformat("cpu %.2f ms/frame, gpu %.2f ms/frame, drawn %.2f times/frame (%.1f redraws/s)",
+                               mUiCpuSeconds / mFrames * 1000.0, gpu_per_frame * 1000.0,
+                               (F64)mUiDraws / mFrames, mUiDraws / seconds)
+                   << LL_ENDL;
+    }
+    if (mFarField[1].frames) {
+        FarFieldStats const& split = mFarField[1];
+        FarFieldStats const& whole = mFarField[0];
+        LL_WARNS() << "VRMOD: timing farfield split over " << split.frames << " frames: "
+                   << llformat("gpu %.2f ms/frame (far pass %.2f, eye passes %.2f)",
+                               (split.farSeconds + split.eyeSeconds) / split.frames * 1000.0,
+                               split.farSeconds / split.frames * 1000.0, split.eyeSeconds / split.frames * 1000.0)
+                   << "; without over " << whole.frames << " frames: "
+                   << (whole.frames ? llformat("gpu %.2f ms/frame", whole.eyeSeconds / whole.frames * 1000.0) : std::string("not timed"))
+                   << LL_ENDL;
+    }
+    if (mFrames && mCulls) {
+        LL_WARNS() << "VRMOD: timing cull over " << mFrames << " frames ("
+                   << (mCullsSkipped ? "shared" : "per eye") << "): "
+                   << llformat("%.2f ms/frame, %.2f culls/frame, %.0f groups / %.0f drawables visible per cull",
+                               mCullSeconds / mFrames * 1000.0, (F64)mCulls / mFrames,
+                               (F64)mCullGroups / mCulls, (F64)mCullDrawables / mCulls)
+                   << LL_ENDL;
+    }
+    for (S32 pass = 0; pass < PASS_STATS && mFrames; ++pass) {
+        PassStats const& stats = mPasses[pass];
+        if (!stats.runs) continue;
+        const F64 gpu_per_run = stats.gpuSamples ? stats.gpuSeconds / stats.gpuSamples : 0.0;
+        LL_WARNS() << "VRMOD: timing passes " << PASS_NAMES[pass] << " over " << mFrames << " frames ("
+                   << (stats.skipped ? "shared" : "per eye") << "): "
+                   << llformat("gpu %.2f ms/frame, cpu %.2f ms/frame, %.2f runs/frame",
+                               gpu_per_run * stats.runs / mFrames * 1000.0, stats.cpuSeconds / mFrames * 1000.0,
+                               (F64)stats.runs / mFrames)
+                   << LL_ENDL;
+    }
+    if (!mPointerEvents) return;
+    LL_WARNS() << "VRMOD: timing pointer " << mPointerEvents << " button events, press to handler "
+               << llformat("avg %.2f ms, max %.2f ms", mPointerLatencySum / mPointerEvents * 1000.0, mPointerLatencyMax * 1000.0)
+               << LL_ENDL;
+    mPointerEvents = 0;
+    mPointerLatencySum = 0.0;
+    mPointerLatencyMax = 0.0;
+}
+
+// Global instance, accessed from the main VR mod code.
+VrModTelemetry gVrModTelemetry;
@@ -0,0 +1,246 @@
+/*
+================================================================================
+VR MOD UI: 2D UI rendered once per HMD frame (humbletim 2026)
+================================================================================
+
+The baseline hooks re-enter `display()` (`goto sec`) for the right eye, so
+`render_ui_2d()` -- every floater, the toolbars, the nearby chat -- was drawn
+twice per HMD frame into the back buffer even though both eyes get the same
+flat UI.
+
+`0002-vrmod-render-ui-2d-once.patch` (applied on top of the sgeo-minimal
+baseline patch) routes `gViewerWindow->draw()` through
+`llviewerVR::RenderUI2D()`. While VR mode is active:
+
+-   the first render pass of an HMD frame draws the UI into a window-sized
+    RGBA target cleared to transparent. The UI's own blending leaves its
+    colour premultiplied; its alpha is made to accumulate as coverage
+    (ONE / ONE_MINUS_SOURCE_ALPHA, `0006-vrmod-llrender-ui-alpha-coverage.patch`),
+    since the UI's SOURCE_ALPHA factors would store a squared alpha there,
+-   every pass composites that target over the world before `vrDisplay()`
+    blits the back buffer into the eye texture, so the pan-and-zoom regions
+    still apply to UI and world alike.
+
+`render_ui()` as a whole still runs per eye: it also finalizes the world
+(`renderFinalize`) and draws the 3D HUD and controller lasers, which differ
+per eye. The controller cursors (`DrawCursors()`) are per eye for the same
+reason and stay outside the cached layer.
+
+By default the layer is redrawn on every HMD frame and shared by both eyes.
+With `vrmod.uiMaxAge` above 0 it is retained across HMD frames and only
+redrawn when the UI may have changed. There is no global "views
+invalidated" flag in LLView, so a small per-frame snapshot of what the UI
+reacts to stands in for one:
+
+-   the pointer position and mouse buttons / modifier keys (hover
+    highlights, drags, controller clicks -- those arrive as mouse events),
+-   keyboard focus, mouse capture, the top control and tooltip visibility
+    (menus, pickers, focus rings),
+-   the number of floaters, and the length and cursor of a focused text
+    field (typing; compared instead of the text itself),
+-   the window size.
+
+Anything else that moves by itself -- incoming chat, the text caret, fades,
+the minimap -- only shows up once the layer is `vrmod.uiMaxAge` seconds
+old, so retention is opt-in. Redraws per second are reported with the UI
+timing.
+
+With `vrmod.uiOverlay` the layer is not composited at all but shown as a
+SteamVR overlay quad instead (VR MOD OVERLAY).
+
+`vrmod.uiOncePerFrame` switches back to drawing the UI on every pass, so the
+cost of both can be compared on the same session: CPU time and GPU time
+(`GL_TIME_ELAPSED` queries, collected a few frames late so nothing stalls)
+per HMD frame are reported as `VRMOD: timing ui` when VR mode is left.
+
+*/
+
+#include "llfloater.h"
+#include "llfocusmgr.h"
+#include "lllineeditor.h"
+#include "llrendertarget.h"
+#include "lltextbase.h"
+#include "lltooltip.h"
+
+// indra/llrender/llrender.cpp, 0006-vrmod-llrender-ui-alpha-coverage.patch
+extern bool gGLBlendAlphaAsCoverage;
+
+struct VrModUiLayer {
+    // what the UI's appearance depends on, compared once per HMD frame
+    struct Snapshot {
+        LLCoordGL mouse;
+        MASK mask = 0;
+        bool leftDown = false, rightDown = false;
+        LLFocusableElement* keyboardFocus = nullptr;
+        LLMouseHandler* mouseCapture = nullptr;
+        LLUICtrl* topCtrl = nullptr;
+        bool toolTip = false;
+        S32 floaters = 0;
+        S32 focusLength = -1, focusCursor = -1;  // focused text field
+        S32 width = 0, height = 0;
+
+        bool operator==(Snapshot const& other) const;
+    };
+
+    LLRenderTarget mTarget;
+    Snapshot mSnapshot;
+    bool mInvalid = true;
+    F64 mDrawnAt = 0.0;
+    VrModGpuTimer mGpuTimer;
+
+    // draws (or reuses) the 2D UI for the current render pass; first_pass
+    // is the first of the HMD frame's one or two passes
+    void render(std::function<void()> const& draw, bool first_pass);
+
+    // forces a redraw on the next HMD frame
+    void invalidate() { mInvalid = true; }
+
+    // frees the target and queries (VR mode left)
+    void release();
+
+private:
+    bool needsRedraw();
+    static Snapshot snapshot();
+    bool redraw(std::function<void()> const& draw);
+    void composite();
+};
+
+void VrModUiLayer::render(std::function<void()> const& draw, bool first_pass) {
+    mGpuTimer.collect([](F64 seconds) { gVrModTelemetry.uiGpuTimed(seconds); });
+
+    LLTimer timer;
+    mGpuTimer.begin();
+    bool drawn = true;
+    const bool overlay = first_pass ? gVrModOverlay.update() : gVrModOverlay.active();
+    if (overlay) {
+        // the compositor shows the layer; the eye views stay free of the UI
+        drawn = first_pass && (needsRedraw() || !mTarget.isComplete());
+        if (drawn) {
+            if (redraw(draw)) {
+                gVrModOverlay.submit(mTarget.getTexture());
+            } else {
+                gVrModOverlay.hide();
+                draw();
+            }
+        }
+    } else if (!gVrModSettings->uiOncePerFrame) {
+        draw();
+    } else if ((first_pass && needsRedraw()) || !mTarget.isComplete()) {
+        if (redraw(draw)) {
+            composite();
+        } else {
+            draw(); // no target; draw directly like before
+        }
+    } else {
+        composite();
+        drawn = false;
+    }
+    mGpuTimer.end();
+    gVrModTelemetry.uiRendered(timer.getElapsedTimeF64(), drawn);
+}
+
+void VrModUiLayer::release() {
+    mTarget.release();
+    mInvalid = true;
+    mGpuTimer.release();
+}
+
+bool VrModUiLayer::Snapshot::operator==(Snapshot const& other) const {
+    return mouse == other.mouse && mask == other.mask
+        && leftDown == other.leftDown && rightDown == other.rightDown
+        && keyboardFocus == other.keyboardFocus && mouseCapture == other.mouseCapture
+        && topCtrl == other.topCtrl && toolTip == other.toolTip
+        && floaters == other.floaters
+        && focusLength == other.focusLength && focusCursor == other.focusCursor
+        && width == other.width && height == other.height;
+}
+
+/*static*/ VrModUiLayer::Snapshot VrModUiLayer::snapshot() {
+    Snapshot snap;
+    snap.mouse = gViewerWindow->getCurrentMouse();
+    snap.mask = gKeyboard->currentMask(TRUE);
+    snap.leftDown = gViewerWindow->getLeftMouseDown();
+    snap.rightDown = gViewerWindow->getRightMouseDown();
+    snap.keyboardFocus = gFocusMgr.getKeyboardFocus();
+    snap.mouseCapture = gFocusMgr.getMouseCapture();
+    snap.topCtrl = gFocusMgr.getTopCtrl();
+    snap.toolTip = LLToolTipMgr::instance().toolTipVisible();
+    snap.floaters = gFloaterView ? gFloaterView->getChildCount() : 0;
+    // typing changes the length or moves the cursor; both are plain members,
+    // unlike the control's value, which copies the whole text
+    if (LLLineEditor* line = dynamic_cast<LLLineEditor*>(snap.keyboardFocus)) {
+        snap.focusLength = line->getLength();
+        snap.focusCursor = line->getCursor();
+    } else if (LLTextBase* text = dynamic_cast<LLTextBase*>(snap.keyboardFocus)) {
+        snap.focusLength = text->getLength();
+    }
+    snap.width = gViewerWindow->getWindowWidthRaw();
+    snap.height = gViewerWindow->getWindowHeightRaw();
+    return snap;
+}
+
+bool VrModUiLayer::needsRedraw() {
+    Snapshot snap = snapshot();
+    const bool changed = !(snap == mSnapshot);
+    mSnapshot = snap;
+    const bool stale = LLTimer::getTotalSeconds() - mDrawnAt >= gVrModSettings->uiMaxAge;
+    return mInvalid || changed || stale;
+}
+
+bool VrModUiLayer::redraw(std::function<void()> const& draw) {
+    const U32 width = gViewerWindow->getWindowWidthRaw();
+    const U32 height = gViewerWindow->getWindowHeightRaw();
+    if (!mTarget.isComplete() || mTarget.getWidth() != width || mTarget.getHeight() != height) {
+        mTarget.release();
+        if (!mTarget.allocate(width, height, GL_RGBA, false)) {
+            LL_WARNS() << "VRMOD: could not allocate " << width << "x" << height << " UI layer; drawing the UI per eye" << LL_ENDL;
+            return false;
+        }
+    }
+
+    GLfloat clear_color[4];
+    glGetFloatv(GL_COLOR_CLEAR_VALUE, clear_color);
+    mTarget.bindTarget();
+    glClearColor(0.f, 0.f, 0.f, 0.f);
+    mTarget.clear();
+    glClearColor(clear_color[0], clear_color[1], clear_color[2], clear_color[3]);
+
+    // the UI normally leaves the back buffer's alpha alone; here it is the
+    // coverage the composite blends with. The UI's blendFunc() and
+    // setSceneBlendType() calls keep the coverage alpha factors while the
+    // flag is set; the first call sets them for the state already current.
+    gGL.setColorMask(true, true);
+    gGLBlendAlphaAsCoverage = true;
+    gGL.blendFunc(LLRender::BF_SOURCE_ALPHA, LLRender::BF_ONE_MINUS_SOURCE_ALPHA,
+                  LLRender::BF_ONE, LLRender::BF_ONE_MINUS_SOURCE_ALPHA);
+    draw();
+    gGLBlendAlphaAsCoverage = false;
+    gGL.setSceneBlendType(LLRender::BT_ALPHA);
+    gGL.setColorMask(true, false);
+    mTarget.flush();
+    mInvalid = false;
+    mDrawnAt = LLTimer::getTotalSeconds();
+    return true;
+}
+
+void VrModUiLayer::composite() {
+    const S32 width = gViewerWindow->getWindowWidthScaled();
+    const S32 height = gViewerWindow->getWindowHeightScaled();
+
+    gUIProgram.bind();
+    gGL.blendFunc(LLRender::BF_ONE, LLRender::BF_ONE_MINUS_SOURCE_ALPHA);
+    gGL.getTexUnit(0)->bind(&mTarget);
+    gGL.color4f(1.f, 1.f, 1.f, 1.f);
+    gGL.begin(LLRender::TRIANGLE_STRIP);
+    gGL.texCoord2f(0.f, 0.f); gGL.vertex2i(0, 0);
+    gGL.texCoord2f(1.f, 0.f); gGL.vertex2i(width, 0);
+    gGL.texCoord2f(0.f, 1.f); gGL.vertex2i(0, height);
+    gGL.texCoord2f(1.f, 1.f); gGL.vertex2i(width, height);
+    gGL.end();
+    gGL.getTexUnit(0)->unbind(LLTexUnit::TT_TEXTURE);
+    gGL.setSceneBlendType(LLRender::BT_ALPHA);
+    gUIProgram.unbind();
+}
+
+// Global instance, accessed from the main VR mod code.
+VrModUiLayer gVrModUiLayer;
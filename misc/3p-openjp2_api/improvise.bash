@@ -118,11 +118,20 @@ test -s openjpeg/src/lib/openjpeg.h || (
   
   cp -av stage/include/openjpeg/LICENSE stage/LICENSES/openjp2.txt
   cp -av openjp2_api.h stage/include/openjpeg.h
+  cp -av openjp2_api.*.c++ stage/include/
 
   FILES=(
    autobuild-package.xml
    LICENSES/openjp2.txt
    include/openjpeg.h
+   include/openjp2_api.stream.c++
+   include/openjp2_api.decoder_context.c++
+   include/openjp2_api.codestream.c++
+   include/openjp2_api.progressive.c++
+   include/openjp2_api.scheduler.c++
+   include/openjp2_api.simd.c++
+   include/openjp2_api.encode.c++
+   include/openjp2_api.texture_cache.c++
   )
 
   for x in ${FILES[@]} ; do test -s stage/$x || { echo "'$x' invalid" >&2 ; exit 38 ; } ; done || return 61
@@ -144,3 +153,58 @@ test -s openjpeg/src/lib/openjpeg.h || (
   return 0
 
 )}
+
+# transcodes a local cache of classic .j2c assets into HTJ2K (Part 15) copies
+# for evaluation -- OpenJPEG 2.5 decodes HT codestreams but has no HT encoder,
+# so this round-trips through openjp2_api_bench (decode) and OpenJPH's
+# ojph_compress (https://github.com/aous72/OpenJPH; built with TIFF support
+# for 2/4 component assets). compare afterwards with:
+#   ./openjp2_api_bench ht <classic_dir> <ht_dir>
+transcode_htj2k() {(
+  set -Euo pipefail
+  local classic_dir="$1" ht_dir="$2" bench=${3:-./openjp2_api_bench} ojph=${OJPH_COMPRESS:-ojph_compress}
+  test -d "$classic_dir" || { echo "classic_dir('$classic_dir') not found" >&2 ; return 71 ; }
+  test -x "$bench" || { echo "openjp2_api_bench('$bench') not found (see readme.md)" >&2 ; return 72 ; }
+  command -v "$ojph" >/dev/null || { echo "ojph_compress('$ojph') not found" >&2 ; return 73 ; }
+  mkdir -pv "$ht_dir"
+  local tmp=$(mktemp -d)
+  trap "rm -rf '$tmp'" EXIT
+
+  local count=0 failed=0 src name width height comps reversible levels path
+  for src in "$classic_dir"/*.j2c ; do
+    test -s "$src" || continue
+    name=$(basename "$src")
+    read -r width height comps reversible levels path < <("$bench" dump "$src" "$tmp/image" || true)
+    if [[ -z "${path:-}" ]] ; then echo "[skip] $name: decode failed" >&2 ; failed=$((failed+1)) ; continue ; fi
+    local args=( -i "$path" -o "$ht_dir/$name" -num_decomps $levels )
+    # keep the classic asset's wavelet: lossless stays lossless, lossy gets a fine quantizer
+    if [[ $reversible == 1 ]] ; then args+=( -reversible true ) ; else args+=( -qstep 0.0039 ) ; fi
+    if "$ojph" "${args[@]}" >/dev/null ; then
+      count=$((count+1))
+    else
+      echo "[fail] $name (${width}x${height}x${comps})" >&2 ; failed=$((failed+1))
+    fi
+    rm -f "$path" ; path=
+  done
+  echo "transcoded $count assets into $ht_dir ($failed skipped/failed)" >&2
+  test $count -gt 0 || return 74
+)}
+
+# compares two `openjp2_api_bench suite --json` result files, e.g. before and
+# after bumping the pinned OpenJPEG commit: per-category decode speed ratio
+# (after / before) and allocation / peak heap deltas per decode
+compare_bench_suite() {(
+  set -Euo pipefail
+  local before="$1" after="$2"
+  test -s "$before" || { echo "before('$before') not found" >&2 ; return 81 ; }
+  test -s "$after" || { echo "after('$after') not found" >&2 ; return 82 ; }
+  jq -r -n --slurpfile a "$before" --slurpfile b "$after" '
+    $a[0] as $old | $b[0] as $new
+    | (if $old.corpusHash != $new.corpusHash then "# corpus bytes differ: the encoder changed as well" else empty end),
+      (($old.categories | map({ key: .name, value: . }) | from_entries) as $o
+       | $new.categories[] | . as $c | $o[$c.name] as $p | select($p != null)
+       | [ $c.name,
+           "\(($c.megapixelsPerSecond / $p.megapixelsPerSecond * 100 | round) / 100)x",
+           "allocs \($c.allocsPerDecode - $p.allocsPerDecode | if . > 0 then "+\(.)" else "\(.)" end)",
+           "peak \(($c.peakBytes - $p.peakBytes) / 1024 | round) KB" ] | @tsv)'
+)}
@@ -0,0 +1,1164 @@
+// openjp2_api standalone benchmarks
+// copyright (c) 2026 humbletim
+//
+// not part of the viewer build; compile the amalgamation header directly:
+//   clang++ -std=c++17 -O2 -xc++ -DOPENJP2_API_BENCHMARK -Istage/include stage/include/openjpeg.h -o openjp2_api_bench
+//   ./openjp2_api_bench small [iterations]
+//   ./openjp2_api_bench progressive [chunk bytes]
+//   ./openjp2_api_bench batch [jobs]
+//   ./openjp2_api_bench simd [iterations]
+//   ./openjp2_api_bench roi [iterations]
+//   ./openjp2_api_bench dump <in.j2c> <out prefix>
+//   ./openjp2_api_bench ht <classic dir> <htj2k dir> [iterations]
+//   ./openjp2_api_bench encode [size] [iterations]
+//   ./openjp2_api_bench stream [count]
+//   ./openjp2_api_bench cache [assets] [requests]
+//   ./openjp2_api_bench suite [--json out.json] [--sizes 64,256,1024] [--min-mp 4] [--corpus dir] [--ht dir]
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
+
+namespace openjp2_api { namespace bench {
+
+    using steady = std::chrono::steady_clock;
+
+    // --- allocation accounting ---
+    // every OpenJPEG allocation (opj_malloc.c is renamed in this build, see
+    // openjp2_api.h) and every C++ new goes through a size header so live and
+    // peak bytes can be tracked without platform specific msize calls
+    struct AllocCounters {
+        std::atomic<OPJ_UINT64> count{ 0 };
+        std::atomic<OPJ_UINT64> bytes{ 0 };   // cumulative
+        std::atomic<OPJ_INT64> live{ 0 };
+        std::atomic<OPJ_INT64> peak{ 0 };
+    };
+    AllocCounters allocs;
+
+    // 64 bytes keeps the 16/32-byte alignment of opj_aligned_*malloc intact
+    constexpr size_t ALLOC_HEADER = 64;
+
+    void* alloc_track(void* base, size_t size) {
+        if (!base) return nullptr;
+        memcpy(base, &size, sizeof(size));
+        allocs.count++;
+        allocs.bytes += size;
+        OPJ_INT64 live = allocs.live += (OPJ_INT64)size;
+        OPJ_INT64 peak = allocs.peak.load(std::memory_order_relaxed);
+        while (live > peak && !allocs.peak.compare_exchange_weak(peak, live)) {}
+        return static_cast<char*>(base) + ALLOC_HEADER;
+    }
+
+    // returns the allocator's own pointer and forgets the block
+    void* alloc_untrack(void* ptr) {
+        if (!ptr) return nullptr;
+        void* base = static_cast<char*>(ptr) - ALLOC_HEADER;
+        size_t size;
+        memcpy(&size, base, sizeof(size));
+        allocs.live -= (OPJ_INT64)size;
+        return base;
+    }
+
+    struct AllocSnapshot {
+        OPJ_UINT64 count = 0, bytes = 0;
+        OPJ_INT64 live = 0;
+    };
+
+    // starts a measurement: peak is re-based to the current live bytes
+    AllocSnapshot alloc_begin() {
+        AllocSnapshot snap{ allocs.count.load(), allocs.bytes.load(), allocs.live.load() };
+        allocs.peak.store(snap.live);
+        return snap;
+    }
+}} // namespace openjp2_api::bench
+
+void* opj_malloc(size_t size) {
+    if (!size) return nullptr;
+    return openjp2_api::bench::alloc_track(opj_malloc_untracked(size + openjp2_api::bench::ALLOC_HEADER), size);
+}
+
+void* opj_calloc(size_t num, size_t size) {
+    if (!num || !size) return nullptr;
+    if (size > (SIZE_MAX - openjp2_api::bench::ALLOC_HEADER) / num) return nullptr;
+    return openjp2_api::bench::alloc_track(opj_calloc_untracked(1, num * size + openjp2_api::bench::ALLOC_HEADER), num * size);
+}
+
+void* opj_realloc(void* ptr, size_t size) {
+    using namespace openjp2_api::bench;
+    if (!size) return nullptr; // (matches upstream: ptr is left alone)
+    return alloc_track(opj_realloc_untracked(alloc_untrack(ptr), size + ALLOC_HEADER), size);
+}
+
+void opj_free(void* ptr) {
+    opj_free_untracked(openjp2_api::bench::alloc_untrack(ptr));
+}
+
+void* opj_aligned_malloc(size_t size) {
+    if (!size) return nullptr;
+    return openjp2_api::bench::alloc_track(opj_aligned_malloc_untracked(size + openjp2_api::bench::ALLOC_HEADER), size);
+}
+
+void* opj_aligned_realloc(void* ptr, size_t size) {
+    using namespace openjp2_api::bench;
+    if (!size) return nullptr;
+    return alloc_track(opj_aligned_realloc_untracked(alloc_untrack(ptr), size + ALLOC_HEADER), size);
+}
+
+void* opj_aligned_32_malloc(size_t size) {
+    if (!size) return nullptr;
+    return openjp2_api::bench::alloc_track(opj_aligned_32_malloc_untracked(size + openjp2_api::bench::ALLOC_HEADER), size);
+}
+
+void* opj_aligned_32_realloc(void* ptr, size_t size) {
+    using namespace openjp2_api::bench;
+    if (!size) return nullptr;
+    return alloc_track(opj_aligned_32_realloc_untracked(alloc_untrack(ptr), size + ALLOC_HEADER), size);
+}
+
+void opj_aligned_free(void* ptr) {
+    opj_aligned_free_untracked(openjp2_api::bench::alloc_untrack(ptr));
+}
+
+void* operator new(size_t size) {
+    void* ptr = openjp2_api::bench::alloc_track(malloc(size + openjp2_api::bench::ALLOC_HEADER), size);
+    if (!ptr) throw std::bad_alloc();
+    return ptr;
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept {
+    free(openjp2_api::bench::alloc_untrack(ptr));
+}
+
+void operator delete[](void* ptr) noexcept {
+    operator delete(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    operator delete(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept {
+    operator delete(ptr);
+}
+
+namespace openjp2_api { namespace bench {
+
+    double elapsed_since(steady::time_point start) {
+        return std::chrono::duration<double>(steady::now() - start).count();
+    }
+
+    // deterministic "texture-like" content: gradients plus LCG noise so the
+    // entropy coder has something realistic to chew on
+    opj_image_t* make_synthetic_image(OPJ_UINT32 w, OPJ_UINT32 h, OPJ_UINT32 numcomps, OPJ_UINT32 seed) {
+        opj_image_cmptparm_t cmpt[4];
+        memset(cmpt, 0, sizeof(cmpt));
+        for (OPJ_UINT32 c = 0; c < numcomps; c++) {
+            cmpt[c].dx = cmpt[c].dy = 1;
+            cmpt[c].w = w;
+            cmpt[c].h = h;
+            cmpt[c].prec = 8;
+            cmpt[c].sgnd = 0;
+        }
+        opj_image_t* image = opj_image_create(numcomps, cmpt, numcomps >= 3 ? OPJ_CLRSPC_SRGB : OPJ_CLRSPC_GRAY);
+        if (!image) return nullptr;
+        image->x0 = image->y0 = 0;
+        image->x1 = w;
+        image->y1 = h;
+        OPJ_UINT32 lcg = seed * 2654435761u + 1;
+        for (OPJ_UINT32 c = 0; c < numcomps; c++) {
+            for (OPJ_UINT32 y = 0; y < h; y++) {
+                for (OPJ_UINT32 x = 0; x < w; x++) {
+                    lcg = lcg * 1664525u + 1013904223u;
+                    OPJ_INT32 v = (OPJ_INT32)((x * (c + 1) * 255) / w + (y * 255) / h) / 2 + (OPJ_INT32)(lcg >> 28) - 8;
+                    image->comps[c].data[y * w + x] = std::min(255, std::max(0, v));
+                }
+            }
+        }
+        return image;
+    }
+
+    struct EncodeOptions {
+        OPJ_UINT32 layers = 1;
+        bool lossless = true;
+        OPJ_UINT32 tile = 0; // 0 == untiled
+        int threads = 1;
+    };
+
+    opj_cparameters_t encode_parameters(opj_image_t const* image, EncodeOptions const& opts) {
+        opj_cparameters_t cp;
+        opj_set_default_encoder_parameters(&cp);
+        OPJ_UINT32 w = image->x1 - image->x0, h = image->y1 - image->y0;
+        OPJ_UINT32 extent = opts.tile ? std::min(opts.tile, std::min(w, h)) : std::min(w, h);
+        cp.numresolution = 1;
+        while (cp.numresolution < 6 && (extent >> cp.numresolution) >= 4) cp.numresolution++;
+        cp.tcp_mct = image->numcomps >= 3 ? 1 : 0;
+        cp.irreversible = opts.lossless ? 0 : 1;
+        cp.cp_disto_alloc = 1;
+        cp.tcp_numlayers = (int)opts.layers;
+        for (OPJ_UINT32 l = 0; l < opts.layers; l++) {
+            // rates are compression ratios, last layer lossless (0) when requested
+            cp.tcp_rates[l] = (opts.lossless && l + 1 == opts.layers) ? 0.f : (float)(1 << (2 * (opts.layers - l)));
+        }
+        if (opts.tile) {
+            cp.tile_size_on = OPJ_TRUE;
+            cp.cp_tdx = (int)opts.tile;
+            cp.cp_tdy = (int)opts.tile;
+        }
+        return cp;
+    }
+
+    std::vector<OPJ_BYTE> encode_j2c(opj_image_t* image, EncodeOptions const& opts = {}) {
+        return encode(image, encode_parameters(image, opts), opts.threads);
+    }
+
+    // the "stock" way: everything created and torn down per texture
+    opj_image_t* decode_fresh(std::vector<OPJ_BYTE> const& j2c) {
+        struct { const OPJ_BYTE* data; OPJ_SIZE_T size, offset; } src{ j2c.data(), j2c.size(), 0 };
+        using Src = decltype(src);
+        opj_codec_t* codec = opj_create_decompress(OPJ_CODEC_J2K);
+        opj_stream_t* stream = opj_stream_default_create(OPJ_TRUE);
+        opj_stream_set_read_function(stream, [](void* buffer, OPJ_SIZE_T n, void* user) -> OPJ_SIZE_T {
+            auto* s = static_cast<Src*>(user);
+            if (s->offset >= s->size) return (OPJ_SIZE_T)-1;
+            n = std::min(n, s->size - s->offset);
+            memcpy(buffer, s->data + s->offset, n);
+            s->offset += n;
+            return n;
+        });
+        opj_stream_set_user_data(stream, &src, nullptr);
+        opj_stream_set_user_data_length(stream, j2c.size());
+        opj_dparameters_t params;
+        opj_set_default_decoder_parameters(&params);
+        opj_image_t* image = nullptr;
+        bool ok = opj_setup_decoder(codec, &params)
+            && opj_read_header(stream, codec, &image)
+            && opj_decode(codec, stream, image)
+            && opj_end_decompress(codec, stream);
+        opj_stream_destroy(stream);
+        opj_destroy_codec(codec);
+        if (!ok && image) { opj_image_destroy(image); image = nullptr; }
+        return image;
+    }
+
+    bool same_pixels(opj_image_t const* a, opj_image_t const* b) {
+        if (!a || !b || a->numcomps != b->numcomps) return false;
+        for (OPJ_UINT32 c = 0; c < a->numcomps; c++) {
+            if (a->comps[c].w != b->comps[c].w || a->comps[c].h != b->comps[c].h) return false;
+            if (memcmp(a->comps[c].data, b->comps[c].data, sizeof(OPJ_INT32) * a->comps[c].w * a->comps[c].h)) return false;
+        }
+        return true;
+    }
+
+    // small-image throughput: per-texture setup vs. a reused DecoderContext
+    int bench_small(int argc, char** argv) {
+        int iterations = argc > 0 ? std::max(1, atoi(argv[0])) : 2000;
+        struct Case { OPJ_UINT32 size, comps; };
+        const Case cases[] = { { 16, 4 }, { 32, 4 }, { 64, 3 }, { 64, 4 }, { 128, 3 } };
+
+        printf("%-10s %10s %14s %14s %8s\n", "image", "j2c bytes", "fresh img/s", "context img/s", "speedup");
+        DecoderContext* ctx = threadDecoderContext();
+        for (Case const& c : cases) {
+            opj_image_t* source = make_synthetic_image(c.size, c.size, c.comps, c.size + c.comps);
+            std::vector<OPJ_BYTE> j2c = encode_j2c(source);
+            opj_image_destroy(source);
+            if (j2c.empty()) { fprintf(stderr, "encode failed for %ux%ux%u\n", c.size, c.size, c.comps); return 1; }
+
+            opj_image_t* a = decode_fresh(j2c);
+            opj_image_t* b = decode(ctx, j2c.data(), j2c.size());
+            bool match = same_pixels(a, b);
+            opj_image_destroy(a);
+            opj_image_destroy(b);
+            if (!match) { fprintf(stderr, "context decode mismatch for %ux%ux%u: %s\n", c.size, c.size, c.comps, lastError(ctx).c_str()); return 1; }
+
+            auto start = steady::now();
+            for (int i = 0; i < iterations; i++) opj_image_destroy(decode_fresh(j2c));
+            double fresh = elapsed_since(start);
+
+            start = steady::now();
+            for (int i = 0; i < iterations; i++) opj_image_destroy(decode(ctx, j2c.data(), j2c.size()));
+            double reused = elapsed_since(start);
+
+            char label[32];
+            snprintf(label, sizeof(label), "%ux%ux%u", c.size, c.size, c.comps);
+            printf("%-10s %10zu %14.0f %14.0f %7.2fx\n", label, j2c.size(), iterations / fresh, iterations / reused, fresh / reused);
+        }
+        return 0;
+    }
+
+    // simulated ranged fetch: the codestream arrives in fixed-size chunks and
+    // the image is refreshed after each one -- full re-decode from byte zero
+    // (what the viewer did) vs ProgressiveDecoder
+    int bench_progressive(int argc, char** argv) {
+        OPJ_SIZE_T chunk = argc > 0 ? (OPJ_SIZE_T)std::max(256, atoi(argv[0])) : 4096;
+        struct Case { const char* name; EncodeOptions opts; };
+        const Case cases[] = {
+            { "untiled", { 5, true, 0 } },
+            { "tiled128", { 5, true, 128 } },
+            { "tiled64", { 5, true, 64 } },
+        };
+
+        printf("%-10s %10s %7s %10s %10s %10s %10s %8s\n", "stream", "j2c bytes", "chunks", "naive dec", "naive s", "prog dec", "prog s", "speedup");
+        DecoderContext* ctx = threadDecoderContext();
+        opj_image_t* source = make_synthetic_image(512, 512, 3, 27);
+        for (Case const& c : cases) {
+            std::vector<OPJ_BYTE> j2c = encode_j2c(source, c.opts);
+            if (j2c.empty()) { fprintf(stderr, "encode failed for %s\n", c.name); return 1; }
+            opj_image_t* reference = decode(ctx, j2c.data(), j2c.size());
+            size_t chunks = (j2c.size() + chunk - 1) / chunk;
+
+            auto start = steady::now();
+            for (size_t i = 1; i <= chunks; i++) {
+                opj_image_t* image = decode(ctx, j2c.data(), std::min(j2c.size(), i * chunk));
+                if (image) opj_image_destroy(image);
+            }
+            double naive = elapsed_since(start);
+
+            ProgressiveOptions options;
+            options.expectedSize = j2c.size();
+            ProgressiveDecoder* dec = createProgressiveDecoder(options, ctx);
+            const opj_image_t* image = nullptr;
+            start = steady::now();
+            for (size_t offset = 0; offset < j2c.size(); offset += chunk) {
+                appendBytes(dec, j2c.data() + offset, std::min(chunk, j2c.size() - offset));
+                image = decodeAvailable(dec);
+            }
+            double progressive = elapsed_since(start);
+            ProgressiveStatus st = progressStatus(dec);
+            bool match = st.complete && same_pixels(image, reference);
+            destroyProgressiveDecoder(dec);
+            opj_image_destroy(reference);
+            if (!match) { fprintf(stderr, "progressive result mismatch for %s: %s\n", c.name, lastError(ctx).c_str()); return 1; }
+
+            printf("%-10s %10zu %7zu %10zu %10.3f %10u %10.3f %7.2fx\n", c.name, j2c.size(), chunks,
+                chunks, naive, st.tileDecodes + st.partialDecodes, progressive, naive / progressive);
+        }
+        opj_image_destroy(source);
+        return 0;
+    }
+
+    // teleport-style burst against the DecodeScheduler: a mixed synthetic
+    // corpus submitted all at once with random importance / discard level,
+    // a slice of it cancelled or downgraded while queued
+    int bench_batch(int argc, char** argv) {
+        int jobs = argc > 0 ? std::max(1, atoi(argv[0])) : 1000;
+
+        std::vector<std::shared_ptr<std::vector<OPJ_BYTE>>> corpus;
+        for (OPJ_UINT32 i = 0; i < 20; i++) {
+            OPJ_UINT32 size = 32u << (i % 5), comps = 3 + (i / 5) % 2;
+            opj_image_t* source = make_synthetic_image(size, size, comps, 1000 + i);
+            EncodeOptions opts;
+            opts.layers = 3;
+            auto j2c = std::make_shared<std::vector<OPJ_BYTE>>(encode_j2c(source, opts));
+            opj_image_destroy(source);
+            if (j2c->empty()) { fprintf(stderr, "corpus encode failed (%ux%ux%u)\n", size, size, comps); return 1; }
+            corpus.push_back(j2c);
+        }
+
+        std::vector<int> worker_counts{ 1, 2, 4 };
+        int hw = (int)std::max(1u, std::thread::hardware_concurrency());
+        if (hw > 4) worker_counts.push_back(hw);
+
+        printf("%7s %6s %6s %6s %6s %8s %8s %9s %9s %9s %11s\n", "workers", "done", "cancel", "downgr", "stolen",
+            "img/s", "MP/s", "q p50 ms", "q p95 ms", "q max ms", "q hi/lo ms");
+        for (int workers : worker_counts) {
+            struct Sample { float importance; double queue; };
+            std::mutex samples_mutex;
+            std::vector<Sample> samples;
+            samples.reserve(jobs);
+
+            DecodeScheduler* sched = createDecodeScheduler(workers);
+            std::vector<DecodeJobId> ids;
+            OPJ_UINT32 lcg = 12345;
+            auto next = [&lcg] { lcg = lcg * 1664525u + 1013904223u; return lcg >> 8; };
+            for (int i = 0; i < jobs; i++) {
+                auto const& asset = corpus[next() % corpus.size()];
+                DecodeRequest req;
+                req.data = asset->data();
+                req.size = asset->size();
+                req.keepAlive = asset;
+                req.params.reduce = next() % 3;
+                req.importance = (float)(next() % 1000) / 1000.f;
+                float importance = req.importance;
+                req.onComplete = [&samples_mutex, &samples, importance](DecodeResult&& r) {
+                    if (r.image) opj_image_destroy(r.image);
+                    if (r.status == DecodeResult::CANCELLED) return;
+                    std::lock_guard<std::mutex> lock(samples_mutex);
+                    samples.push_back({ importance, r.queueSeconds });
+                };
+                ids.push_back(submit(sched, std::move(req)));
+            }
+            for (size_t i = 0; i < ids.size(); i++) {
+                if (i % 10 == 3) cancel(sched, ids[i]);
+                else if (i % 7 == 5) downgrade(sched, ids[i], 3);
+            }
+            waitIdle(sched);
+            SchedulerStats st = stats(sched);
+            destroyDecodeScheduler(sched);
+
+            std::vector<double> queue;
+            double hi = 0, lo = 0;
+            size_t nhi = 0, nlo = 0;
+            for (Sample const& s : samples) {
+                queue.push_back(s.queue);
+                if (s.importance >= 0.75f) { hi += s.queue; nhi++; }
+                if (s.importance < 0.25f) { lo += s.queue; nlo++; }
+            }
+            std::sort(queue.begin(), queue.end());
+            auto pct = [&queue](double p) { return queue.empty() ? 0.0 : queue[std::min(queue.size() - 1, (size_t)(p * queue.size()))] * 1e3; };
+            char hilo[32];
+            snprintf(hilo, sizeof(hilo), "%.1f/%.1f", nhi ? hi / nhi * 1e3 : 0.0, nlo ? lo / nlo * 1e3 : 0.0);
+            printf("%7d %6llu %6llu %6llu %6llu %8.0f %8.1f %9.2f %9.2f %9.2f %11s\n", workers,
+                (unsigned long long)st.completed, (unsigned long long)st.cancelled, (unsigned long long)st.downgraded, (unsigned long long)st.stolen,
+                st.completed / st.wallSeconds, st.pixels / st.wallSeconds / 1e6, pct(0.5), pct(0.95), st.queueSecondsMax * 1e3, hilo);
+            if (st.failed) { fprintf(stderr, "%llu decodes failed\n", (unsigned long long)st.failed); return 1; }
+        }
+        return 0;
+    }
+
+    // inverse DWT / MCT per SIMD level: bit-exactness against the baseline
+    // build (the target's own feature set, SSE2 on x64 -- not a scalar
+    // reference) plus per-kernel timings (direct calls for the colour transforms, the
+    // dispatcher's profiling counters for the wavelet passes inside real decodes)
+    int bench_simd(int argc, char** argv) {
+        int iterations = argc > 0 ? std::max(1, atoi(argv[0])) : 10;
+        SimdLevel detected = detectedSimdLevel();
+        SimdLevel initial = simdLevel();
+        printf("detected: %s  (active by default: %s)\n", simdLevelName(detected), simdLevelName(initial));
+
+#if OPENJP2_API_SIMD_DISPATCH
+        {
+            const OPJ_SIZE_T n = 1 << 20;
+            std::vector<OPJ_INT32> rct_in(3 * n), rct_ref, rct_out(3 * n);
+            std::vector<OPJ_FLOAT32> ict_in(3 * n), ict_ref, ict_out(3 * n);
+            OPJ_UINT32 lcg = 29;
+            for (OPJ_SIZE_T i = 0; i < 3 * n; i++) {
+                lcg = lcg * 1664525u + 1013904223u;
+                rct_in[i] = (OPJ_INT32)(lcg >> 23) - 256;
+                ict_in[i] = (OPJ_FLOAT32)((OPJ_INT32)(lcg >> 20) - 2048) / 16.f;
+            }
+            printf("%-12s %-7s %10s %8s\n", "kernel", "level", "Msamp/s", "exact");
+            for (int l = SIMD_BASELINE; l <= detected; l++) {
+                simd::Kernels const& k = simd::KERNELS[l];
+                double rct = 0, ict = 0;
+                for (int i = 0; i < iterations; i++) {
+                    rct_out = rct_in;
+                    auto start = steady::now();
+                    k.mct_decode(&rct_out[0], &rct_out[n], &rct_out[2 * n], n);
+                    rct += elapsed_since(start);
+                    ict_out = ict_in;
+                    start = steady::now();
+                    k.mct_decode_real(&ict_out[0], &ict_out[n], &ict_out[2 * n], n);
+                    ict += elapsed_since(start);
+                }
+                if (l == SIMD_BASELINE) { rct_ref = rct_out; ict_ref = ict_out; }
+                bool rct_exact = rct_out == rct_ref;
+                bool ict_exact = !memcmp(ict_out.data(), ict_ref.data(), ict_ref.size() * sizeof(OPJ_FLOAT32));
+                printf("%-12s %-7s %10.1f %8s\n", simd::KERNEL_NAMES[simd::KERNEL_RCT], simdLevelName((SimdLevel)l), n * iterations / rct / 1e6, rct_exact ? "yes" : "NO");
+                printf("%-12s %-7s %10.1f %8s\n", simd::KERNEL_NAMES[simd::KERNEL_ICT], simdLevelName((SimdLevel)l), n * iterations / ict / 1e6, ict_exact ? "yes" : "NO");
+                if (!rct_exact || !ict_exact) { setSimdLevel(initial); return 1; }
+            }
+        }
+#endif
+
+        opj_image_t* source = make_synthetic_image(1024, 1024, 3, 29);
+        struct Case { const char* name; EncodeOptions opts; int kernel; };
+        const Case cases[] = {
+            { "lossless", { 1, true, 0 }, simd::KERNEL_DWT53 },
+            { "lossy", { 1, false, 0 }, simd::KERNEL_DWT97 },
+        };
+        DecoderContext* ctx = threadDecoderContext();
+        printf("\n%-9s %-7s %12s %12s %10s %8s\n", "stream", "level", "idwt ms", "color ms", "decode ms", "exact");
+        for (Case const& c : cases) {
+            std::vector<OPJ_BYTE> j2c = encode_j2c(source, c.opts);
+            setSimdLevel(SIMD_BASELINE);
+            opj_image_t* reference = decode(ctx, j2c.data(), j2c.size());
+            if (!reference) { fprintf(stderr, "%s decode failed: %s\n", c.name, lastError(ctx).c_str()); return 1; }
+            for (int l = SIMD_BASELINE; l <= detected; l++) {
+                setSimdLevel((SimdLevel)l);
+                simd::reset_times();
+                simd::profiling = true;
+                bool exact = true;
+                auto start = steady::now();
+                for (int i = 0; i < iterations; i++) {
+                    opj_image_t* image = decode(ctx, j2c.data(), j2c.size());
+                    exact = exact && same_pixels(image, reference);
+                    if (image) opj_image_destroy(image);
+                }
+                double total = elapsed_since(start);
+                simd::profiling = false;
+                int color = c.kernel == simd::KERNEL_DWT53 ? simd::KERNEL_RCT : simd::KERNEL_ICT;
+                printf("%-9s %-7s %12.2f %12.2f %10.2f %8s\n", c.name, simdLevelName((SimdLevel)l),
+                    simd::times.nanos[c.kernel] / 1e6 / iterations, simd::times.nanos[color] / 1e6 / iterations,
+                    total * 1e3 / iterations, exact ? "yes" : "NO");
+                if (!exact) { opj_image_destroy(reference); setSimdLevel(initial); return 1; }
+            }
+            opj_image_destroy(reference);
+        }
+        opj_image_destroy(source);
+        setSimdLevel(initial);
+        return 0;
+    }
+
+    // does sub (an area decode) match the same samples of full?
+    bool same_area(opj_image_t const* full, opj_image_t const* sub) {
+        if (!full || !sub || full->numcomps != sub->numcomps) return false;
+        for (OPJ_UINT32 c = 0; c < full->numcomps; c++) {
+            opj_image_comp_t const& f = full->comps[c];
+            opj_image_comp_t const& s = sub->comps[c];
+            OPJ_UINT32 ox = ceildivpow2(s.x0, s.factor) - ceildivpow2(f.x0, f.factor);
+            OPJ_UINT32 oy = ceildivpow2(s.y0, s.factor) - ceildivpow2(f.y0, f.factor);
+            if (ox + s.w > f.w || oy + s.h > f.h) return false;
+            for (OPJ_UINT32 y = 0; y < s.h; y++) {
+                if (memcmp(s.data + (OPJ_SIZE_T)y * s.w, f.data + (OPJ_SIZE_T)(oy + y) * f.w + ox, sizeof(OPJ_INT32) * s.w)) return false;
+            }
+        }
+        return true;
+    }
+
+    // large partially visible texture: whole image vs a quarter of its area
+    // (one aligned quadrant, one centered window) at full and half resolution
+    int bench_roi(int argc, char** argv) {
+        int iterations = argc > 0 ? std::max(1, atoi(argv[0])) : 20;
+        struct Case { const char* name; EncodeOptions opts; };
+        const Case cases[] = {
+            { "untiled", { 1, false, 0 } },
+            { "tiled256", { 1, false, 256 } },
+            { "tiled128", { 1, false, 128 } },
+        };
+        const DecodeArea quadrant{ 0, 0, 512, 512 }, centered{ 256, 256, 768, 768 };
+
+        printf("%-9s %6s %10s %12s %12s %8s %8s\n", "stream", "reduce", "full ms", "quadrant ms", "center ms", "quad x", "center x");
+        DecoderContext* ctx = threadDecoderContext();
+        opj_image_t* source = make_synthetic_image(1024, 1024, 3, 30);
+        for (Case const& c : cases) {
+            std::vector<OPJ_BYTE> j2c = encode_j2c(source, c.opts);
+            for (OPJ_UINT32 reduce = 0; reduce < 2; reduce++) {
+                DecodeParams params;
+                params.reduce = reduce;
+                opj_image_t* full = decode(ctx, j2c.data(), j2c.size(), params);
+                for (DecodeArea const* area : { &quadrant, &centered }) {
+                    opj_image_t* sub = decodeArea(ctx, j2c.data(), j2c.size(), *area, params);
+                    bool match = same_area(full, sub);
+                    if (sub) opj_image_destroy(sub);
+                    if (!match) { fprintf(stderr, "%s: area decode mismatch (%s)\n", c.name, lastError(ctx).c_str()); return 1; }
+                }
+                if (full) opj_image_destroy(full);
+
+                double t[3] = {};
+                for (int i = 0; i < iterations; i++) {
+                    auto start = steady::now();
+                    opj_image_destroy(decode(ctx, j2c.data(), j2c.size(), params));
+                    t[0] += elapsed_since(start);
+                    start = steady::now();
+                    opj_image_destroy(decodeArea(ctx, j2c.data(), j2c.size(), quadrant, params));
+                    t[1] += elapsed_since(start);
+                    start = steady::now();
+                    opj_image_destroy(decodeArea(ctx, j2c.data(), j2c.size(), centered, params));
+                    t[2] += elapsed_since(start);
+                }
+                printf("%-9s %6u %10.2f %12.2f %12.2f %7.2fx %7.2fx\n", c.name, reduce,
+                    t[0] * 1e3 / iterations, t[1] * 1e3 / iterations, t[2] * 1e3 / iterations, t[0] / t[1], t[0] / t[2]);
+            }
+        }
+        opj_image_destroy(source);
+        return 0;
+    }
+
+    std::vector<OPJ_BYTE> read_file(std::filesystem::path const& path) {
+        std::vector<OPJ_BYTE> bytes;
+        if (FILE* f = fopen(path.string().c_str(), "rb")) {
+            fseek(f, 0, SEEK_END);
+            long size = ftell(f);
+            fseek(f, 0, SEEK_SET);
+            if (size > 0) {
+                bytes.resize((size_t)size);
+                if (fread(bytes.data(), 1, bytes.size(), f) != bytes.size()) bytes.clear();
+            }
+            fclose(f);
+        }
+        return bytes;
+    }
+
+    // 8-bit interleaved samples, clamped / scaled down from the component precision
+    std::vector<OPJ_BYTE> interleave_8bit(opj_image_t const* image) {
+        OPJ_UINT32 w = image->comps[0].w, h = image->comps[0].h, n = image->numcomps;
+        std::vector<OPJ_BYTE> pixels((size_t)w * h * n);
+        for (OPJ_UINT32 c = 0; c < n; c++) {
+            opj_image_comp_t const& comp = image->comps[c];
+            int shift = comp.prec > 8 ? (int)comp.prec - 8 : 0;
+            int bias = comp.sgnd ? 1 << (comp.prec - 1) : 0;
+            for (OPJ_UINT32 y = 0; y < h; y++) {
+                for (OPJ_UINT32 x = 0; x < w; x++) {
+                    OPJ_INT32 v = comp.data[std::min(y, comp.h - 1) * comp.w + std::min(x, comp.w - 1)];
+                    pixels[((size_t)y * w + x) * n + c] = (OPJ_BYTE)std::min(255, std::max(0, (v + bias) >> shift));
+                }
+            }
+        }
+        return pixels;
+    }
+
+    // PGM/PPM for 1/3 components, minimal uncompressed TIFF for 2/4 (alpha)
+    bool write_image_file(std::string const& path, opj_image_t const* image) {
+        OPJ_UINT32 w = image->comps[0].w, h = image->comps[0].h, n = image->numcomps;
+        std::vector<OPJ_BYTE> pixels = interleave_8bit(image);
+        FILE* f = fopen(path.c_str(), "wb");
+        if (!f) return false;
+        if (n == 1 || n == 3) {
+            fprintf(f, "P%c\n%u %u\n255\n", n == 1 ? '5' : '6', w, h);
+        } else {
+            std::vector<OPJ_BYTE> hdr;
+            auto u16 = [&hdr](OPJ_UINT32 v) { hdr.push_back(v & 0xFF); hdr.push_back((v >> 8) & 0xFF); };
+            auto u32 = [&u16](OPJ_UINT32 v) { u16(v & 0xFFFF); u16(v >> 16); };
+            const OPJ_UINT32 entries = 11, ifd = 8, bps = ifd + 2 + entries * 12 + 4, data = bps + 2 * n;
+            auto entry = [&](OPJ_UINT32 tag, OPJ_UINT32 type, OPJ_UINT32 count, OPJ_UINT32 value) {
+                u16(tag); u16(type); u32(count);
+                if (type == 3 && count == 1) { u16(value); u16(0); } else u32(value);
+            };
+            hdr.insert(hdr.end(), { 'I', 'I', 42, 0 });
+            u32(ifd);
+            u16(entries);
+            entry(256, 4, 1, w);                      // ImageWidth
+            entry(257, 4, 1, h);                      // ImageLength
+            entry(258, 3, n, bps);                    // BitsPerSample (array below)
+            entry(259, 3, 1, 1);                      // Compression: none
+            entry(262, 3, 1, n >= 3 ? 2 : 1);         // Photometric: RGB / MinIsBlack
+            entry(273, 4, 1, data);                   // StripOffsets
+            entry(277, 3, 1, n);                      // SamplesPerPixel
+            entry(278, 4, 1, h);                      // RowsPerStrip
+            entry(279, 4, 1, (OPJ_UINT32)pixels.size()); // StripByteCounts
+            entry(284, 3, 1, 1);                      // PlanarConfiguration: chunky
+            entry(338, 3, 1, 2);                      // ExtraSamples: unassociated alpha
+            u32(0);
+            for (OPJ_UINT32 c = 0; c < n; c++) u16(8);
+            fwrite(hdr.data(), 1, hdr.size(), f);
+        }
+        bool ok = fwrite(pixels.data(), 1, pixels.size(), f) == pixels.size();
+        return fclose(f) == 0 && ok;
+    }
+
+    // helper for improvise.bash transcode_htj2k: decodes one asset to an
+    // ojph_compress-friendly file and prints "width height comps reversible levels path"
+    int bench_dump(int argc, char** argv) {
+        if (argc < 2) { fprintf(stderr, "dump <in.j2c> <out prefix>\n"); return 2; }
+        std::vector<OPJ_BYTE> j2c = read_file(argv[0]);
+        CodestreamInfo info;
+        if (!parseCodestreamHeader(j2c.data(), j2c.size(), info) || info.comps.empty() || info.comps.size() > 4) {
+            fprintf(stderr, "%s: not a (supported) J2C codestream\n", argv[0]);
+            return 1;
+        }
+        DecoderContext* ctx = threadDecoderContext();
+        opj_image_t* image = decode(ctx, j2c.data(), j2c.size());
+        if (!image) { fprintf(stderr, "%s: %s\n", argv[0], lastError(ctx).c_str()); return 1; }
+        OPJ_UINT32 n = image->numcomps;
+        std::string path = std::string(argv[1]) + (n == 1 ? ".pgm" : n == 3 ? ".ppm" : ".tif");
+        bool ok = write_image_file(path, image);
+        if (ok) printf("%u %u %u %d %u %s\n", image->comps[0].w, image->comps[0].h, n, info.reversible ? 1 : 0, info.numresolutions - 1, path.c_str());
+        opj_image_destroy(image);
+        return ok ? 0 : 1;
+    }
+
+    // classic vs HTJ2K copies of the same assets (see transcode_htj2k)
+    int bench_ht(int argc, char** argv) {
+        if (argc < 2) { fprintf(stderr, "ht <classic dir> <htj2k dir> [iterations]\n"); return 2; }
+        namespace fs = std::filesystem;
+        int iterations = argc > 2 ? std::max(1, atoi(argv[2])) : 5;
+        DecoderContext* ctx = threadDecoderContext();
+
+        size_t assets = 0, reversible = 0, exact = 0, not_ht = 0;
+        OPJ_UINT64 classic_bytes = 0, ht_bytes = 0;
+        double classic_seconds = 0, ht_seconds = 0;
+        std::error_code ec;
+        for (fs::directory_entry const& entry : fs::directory_iterator(argv[0], ec)) {
+            if (entry.path().extension() != ".j2c") continue;
+            fs::path ht_path = fs::path(argv[1]) / entry.path().filename();
+            std::vector<OPJ_BYTE> classic = read_file(entry.path());
+            std::vector<OPJ_BYTE> ht = read_file(ht_path);
+            if (classic.empty() || ht.empty()) continue;
+            if (!isHTJ2K(ht.data(), ht.size())) { not_ht++; continue; }
+
+            opj_image_t* a = decode(ctx, classic.data(), classic.size());
+            opj_image_t* b = decode(ctx, ht.data(), ht.size());
+            if (!a || !b) {
+                fprintf(stderr, "%s: decode failed (%s)\n", entry.path().filename().string().c_str(), lastError(ctx).c_str());
+                if (a) opj_image_destroy(a);
+                if (b) opj_image_destroy(b);
+                continue;
+            }
+            CodestreamInfo info;
+            parseCodestreamHeader(classic.data(), classic.size(), info);
+            if (info.reversible) {
+                reversible++;
+                if (same_pixels(a, b)) exact++;
+            }
+            opj_image_destroy(a);
+            opj_image_destroy(b);
+
+            auto start = steady::now();
+            for (int i = 0; i < iterations; i++) opj_image_destroy(decode(ctx, classic.data(), classic.size()));
+            classic_seconds += elapsed_since(start);
+            start = steady::now();
+            for (int i = 0; i < iterations; i++) opj_image_destroy(decode(ctx, ht.data(), ht.size()));
+            ht_seconds += elapsed_since(start);
+
+            assets++;
+            classic_bytes += classic.size();
+            ht_bytes += ht.size();
+        }
+        if (ec) { fprintf(stderr, "%s: %s\n", argv[0], ec.message().c_str()); return 1; }
+        if (!assets) { fprintf(stderr, "no classic/HTJ2K pairs found (%zu candidates were not HTJ2K)\n", not_ht); return 1; }
+
+        printf("assets: %zu  (reversible: %zu, bit-exact after transcode: %zu)\n", assets, reversible, exact);
+        printf("%-8s %12s %12s %10s\n", "", "bytes", "decode ms", "MB/s in");
+        printf("%-8s %12llu %12.2f %10.1f\n", "classic", (unsigned long long)classic_bytes, classic_seconds * 1e3 / iterations, classic_bytes * iterations / classic_seconds / 1e6);
+        printf("%-8s %12llu %12.2f %10.1f\n", "htj2k", (unsigned long long)ht_bytes, ht_seconds * 1e3 / iterations, ht_bytes * iterations / ht_seconds / 1e6);
+        printf("size change %+.1f%%, decode speedup %.2fx\n", 100.0 * ((double)ht_bytes / classic_bytes - 1.0), classic_seconds / ht_seconds);
+        return exact == reversible ? 0 : 1;
+    }
+
+    // snapshot / upload sized encodes: single-threaded vs N threads, with the
+    // multithreaded output required to be byte-identical
+    int bench_encode(int argc, char** argv) {
+        OPJ_UINT32 size = argc > 0 ? (OPJ_UINT32)std::max(64, atoi(argv[0])) : 2048;
+        int iterations = argc > 1 ? std::max(1, atoi(argv[1])) : 2;
+        struct Case { const char* name; OPJ_UINT32 comps; EncodeOptions opts; };
+        const Case cases[] = {
+            { "rgb lossless", 3, { 1, true, 0 } },
+            { "rgb lossy", 3, { 1, false, 0 } },
+            { "rgba lossy 5L", 4, { 5, false, 0 } },
+            { "rgb tiled512", 3, { 1, false, 512 } },
+        };
+        std::vector<int> thread_counts{ 1, 2, 4 };
+        int hw = (int)std::max(1u, std::thread::hardware_concurrency());
+        if (hw > 4) thread_counts.push_back(hw);
+
+        printf("%-14s %7s %10s %10s %8s %9s\n", "image", "threads", "bytes", "MP/s", "speedup", "identical");
+        for (Case const& c : cases) {
+            opj_image_t* source = make_synthetic_image(size, size, c.comps, size + c.comps);
+            std::vector<OPJ_BYTE> reference;
+            double single = 0;
+            for (int threads : thread_counts) {
+                EncodeOptions opts = c.opts;
+                opts.threads = threads;
+                std::vector<OPJ_BYTE> j2c;
+                auto start = steady::now();
+                for (int i = 0; i < iterations; i++) j2c = encode_j2c(source, opts);
+                double seconds = elapsed_since(start) / iterations;
+                if (j2c.empty()) { fprintf(stderr, "%s: encode failed\n", c.name); return 1; }
+                if (threads == 1) {
+                    reference = j2c;
+                    single = seconds;
+                    if (c.opts.lossless) {
+                        opj_image_t* roundtrip = decode(threadDecoderContext(), j2c.data(), j2c.size());
+                        bool lossless = same_pixels(roundtrip, source);
+                        if (roundtrip) opj_image_destroy(roundtrip);
+                        if (!lossless) { fprintf(stderr, "%s: lossless round trip mismatch\n", c.name); return 1; }
+                    }
+                }
+                bool identical = j2c == reference;
+                printf("%-14s %7d %10zu %10.1f %7.2fx %9s\n", c.name, threads, j2c.size(),
+                    (double)size * size / seconds / 1e6, single / seconds, identical ? "yes" : "NO");
+                if (!identical) return 1;
+            }
+            opj_image_destroy(source);
+        }
+        return 0;
+    }
+
+    // decodes whatever stream it is given with a fresh codec; destroys the stream
+    opj_image_t* decode_stream(opj_stream_t* stream) {
+        if (!stream) return nullptr;
+        opj_codec_t* codec = opj_create_decompress(OPJ_CODEC_J2K);
+        opj_dparameters_t params;
+        opj_set_default_decoder_parameters(&params);
+        opj_image_t* image = nullptr;
+        bool ok = opj_setup_decoder(codec, &params)
+            && opj_read_header(stream, codec, &image)
+            && opj_decode(codec, stream, image)
+            && opj_end_decompress(codec, stream);
+        opj_stream_destroy(stream);
+        opj_destroy_codec(codec);
+        if (!ok && image) { opj_image_destroy(image); image = nullptr; }
+        return image;
+    }
+
+    // cache-directory style load: a corpus of .j2c files decoded through
+    // fread + copy vs a read-only mapping, both via DecoderContext and via
+    // plain file streams (stdio vs createMappedFileStream). The files are
+    // written just before, so this measures the warm page cache case.
+    int bench_stream(int argc, char** argv) {
+        namespace fs = std::filesystem;
+        int count = argc > 0 ? std::max(1, atoi(argv[0])) : 3000;
+        const OPJ_UINT32 sizes[] = { 32, 64, 128, 256, 512 };
+
+        fs::path dir = fs::temp_directory_path() / "openjp2_api_bench_stream";
+        std::error_code ec;
+        fs::create_directories(dir, ec);
+        std::vector<std::string> paths;
+        std::vector<opj_image_t*> expected;
+        OPJ_UINT64 total_bytes = 0;
+        for (int i = 0; i < count; i++) {
+            OPJ_UINT32 size = sizes[i % 5];
+            opj_image_t* source = make_synthetic_image(size, size, 3 + (i & 1), (OPJ_UINT32)i);
+            std::vector<OPJ_BYTE> j2c = encode_j2c(source, { 5, false, 0 });
+            opj_image_destroy(source);
+            std::string path = (dir / ("asset" + std::to_string(i) + ".j2c")).string();
+            FILE* f = fopen(path.c_str(), "wb");
+            bool written = f && fwrite(j2c.data(), 1, j2c.size(), f) == j2c.size();
+            if (f) fclose(f);
+            if (j2c.empty() || !written) { fprintf(stderr, "%s: could not write\n", path.c_str()); return 1; }
+            paths.push_back(path);
+            expected.push_back(decode_fresh(j2c));
+            total_bytes += j2c.size();
+        }
+
+        DecoderContext* ctx = threadDecoderContext();
+        struct Path {
+            const char* name;
+            std::function<opj_image_t*(std::string const&)> load;
+        };
+        const Path loaders[] = {
+            { "fread + context", [ctx](std::string const& path) {
+                std::vector<OPJ_BYTE> bytes = read_file(path);
+                return decode(ctx, bytes.data(), bytes.size());
+            } },
+            { "mmap + context", [ctx](std::string const& path) {
+                MappedFile* file = mapFile(path.c_str());
+                opj_image_t* image = decode(ctx, mappedData(file), mappedSize(file));
+                unmapFile(file);
+                return image;
+            } },
+            { "stdio stream", [](std::string const& path) {
+                return decode_stream(opj_stream_create_default_file_stream(path.c_str(), OPJ_TRUE));
+            } },
+            { "mapped stream", [](std::string const& path) {
+                return decode_stream(createMappedFileStream(path.c_str()));
+            } },
+        };
+
+        printf("%zu assets, %.1f KB total\n", paths.size(), total_bytes / 1024.0);
+        printf("%-16s %10s %10s %8s\n", "path", "assets/s", "MB/s in", "speedup");
+        int status = 0;
+        double baseline = 0;
+        for (Path const& loader : loaders) {
+            for (size_t i = 0; i < paths.size(); i++) {
+                opj_image_t* image = loader.load(paths[i]);
+                bool match = same_pixels(image, expected[i]);
+                if (image) opj_image_destroy(image);
+                if (!match) { fprintf(stderr, "%s: %s mismatch\n", loader.name, paths[i].c_str()); status = 1; break; }
+            }
+            auto start = steady::now();
+            for (std::string const& path : paths) opj_image_destroy(loader.load(path));
+            double seconds = elapsed_since(start);
+            if (!baseline) baseline = seconds;
+            printf("%-16s %10.0f %10.1f %7.2fx\n", loader.name, paths.size() / seconds, total_bytes / seconds / 1e6, baseline / seconds);
+        }
+
+        for (opj_image_t* image : expected) opj_image_destroy(image);
+        fs::remove_all(dir, ec);
+        return status;
+    }
+
+    // login / region revisit pattern: a skewed request trace over a corpus of
+    // assets at mixed discard levels, decoded without a cache, through a cold
+    // TextureCache (budget: a quarter of the decoded corpus) and again after
+    // reopening it as the next session would
+    int bench_cache(int argc, char** argv) {
+        namespace fs = std::filesystem;
+        int assets = argc > 0 ? std::max(1, atoi(argv[0])) : 300;
+        int requests = argc > 1 ? std::max(1, atoi(argv[1])) : 3000;
+        const OPJ_UINT32 sizes[] = { 64, 128, 256, 512, 1024 };
+
+        struct Asset { std::string uuid; std::vector<OPJ_BYTE> j2c; };
+        std::vector<Asset> corpus;
+        OPJ_UINT64 decoded_bytes = 0;
+        for (int i = 0; i < assets; i++) {
+            OPJ_UINT32 size = sizes[i % 5], comps = 3 + (i & 1);
+            opj_image_t* source = make_synthetic_image(size, size, comps, (OPJ_UINT32)i);
+            char uuid[40];
+            snprintf(uuid, sizeof(uuid), "%08x-0000-4000-8000-%012x", (unsigned)i * 2654435761u, (unsigned)i);
+            corpus.push_back(Asset{ uuid, encode_j2c(source, { 5, false, 0 }) });
+            opj_image_destroy(source);
+            if (corpus.back().j2c.empty()) { fprintf(stderr, "encode failed for asset %d\n", i); return 1; }
+            decoded_bytes += (OPJ_UINT64)size * size * comps;
+        }
+
+        struct Request { size_t asset; OPJ_UINT32 discard; };
+        std::vector<Request> trace;
+        OPJ_UINT32 lcg = 12345;
+        for (int i = 0; i < requests; i++) {
+            lcg = lcg * 1664525u + 1013904223u;
+            double u = (lcg >> 8) / double(1 << 24);
+            trace.push_back(Request{ (size_t)(assets * u * u * u), (lcg >> 4) % 3 });
+        }
+
+        DecoderContext* ctx = threadDecoderContext();
+        fs::path dir = fs::temp_directory_path() / "openjp2_api_bench_cache";
+        std::error_code ec;
+        fs::remove_all(dir, ec);
+        TextureCacheOptions options;
+        options.directory = dir.string();
+        options.maxBytes = decoded_bytes / 4;
+
+        printf("%d assets (%.1f MB decoded), %d requests, cache budget %.1f MB\n", assets, decoded_bytes / 1e6, requests, options.maxBytes / 1e6);
+        printf("%-14s %9s %10s %10s %10s %9s %8s\n", "pass", "hit rate", "hit ms", "miss ms", "total s", "evicted", "speedup");
+
+        auto start = steady::now();
+        for (Request const& r : trace) {
+            DecodeParams params;
+            params.reduce = r.discard;
+            opj_image_destroy(decode(ctx, corpus[r.asset].j2c.data(), corpus[r.asset].j2c.size(), params));
+        }
+        double uncached = elapsed_since(start);
+        printf("%-14s %9s %10s %10.3f %10.3f %9s %8s\n", "no cache", "-", "-", uncached * 1e3 / requests, uncached, "-", "1.00x");
+
+        int status = 0;
+        const char* passes[] = { "cold session", "next session" };
+        for (const char* pass : passes) {
+            TextureCache* cache = createTextureCache(options);
+            if (!cache) { fprintf(stderr, "%s: cannot create cache\n", options.directory.c_str()); return 1; }
+            start = steady::now();
+            for (Request const& r : trace) {
+                Asset const& asset = corpus[r.asset];
+                DecodeParams params;
+                params.reduce = r.discard;
+                opj_image_destroy(decodeCached(cache, ctx, asset.uuid, asset.j2c.data(), asset.j2c.size(), params));
+            }
+            double seconds = elapsed_since(start);
+            TextureCacheStats st = stats(cache);
+            for (size_t i = 0; i < std::min<size_t>(64, trace.size()); i++) { // cached pixels must match a plain decode
+                Asset const& asset = corpus[trace[i].asset];
+                opj_image_t* cached = loadCached(cache, asset.uuid, trace[i].discard, asset.j2c.size());
+                if (!cached) continue;
+                DecodeParams params;
+                params.reduce = trace[i].discard;
+                opj_image_t* reference = decode(ctx, asset.j2c.data(), asset.j2c.size(), params);
+                if (!same_pixels(cached, reference)) { fprintf(stderr, "%s: %s@%u mismatch\n", pass, asset.uuid.c_str(), trace[i].discard); status = 1; }
+                opj_image_destroy(cached);
+                if (reference) opj_image_destroy(reference);
+            }
+            OPJ_UINT64 misses = std::max<OPJ_UINT64>(1, st.misses);
+            printf("%-14s %8.1f%% %10.3f %10.3f %10.3f %9llu %7.2fx\n", pass, 100.0 * st.hits / trace.size(),
+                st.hits ? st.loadSeconds * 1e3 / st.hits : 0.0, st.decodeSeconds * 1e3 / misses, seconds,
+                (unsigned long long)st.evictions, uncached / seconds);
+            destroyTextureCache(cache);
+        }
+        fs::remove_all(dir, ec);
+        return status;
+    }
+
+    // 64-bit FNV-1a -- identifies the corpus bytes in suite results
+    OPJ_UINT64 fnv1a(std::vector<OPJ_BYTE> const& bytes) {
+        OPJ_UINT64 hash = 14695981039346656037ull;
+        for (OPJ_BYTE b : bytes) hash = (hash ^ b) * 1099511628211ull;
+        return hash;
+    }
+
+    // regression suite for OpenJPEG bumps: a deterministic corpus (size x
+    // components x layers x tiling x wavelet) encoded with the bundled
+    // encoder, decoded through a DecoderContext. Reports MP/s plus
+    // allocations and peak live heap per decode, per category, as a table
+    // and optionally as JSON (--json path, "-" for stdout). The corpus hash
+    // tells whether two result files measured the same bytes.
+    // OpenJPEG cannot encode HTJ2K: --corpus writes the classic corpus out,
+    // transcode_htj2k (improvise.bash) converts it, --ht adds those files as
+    // "-ht" categories. Without --ht the HT categories are reported skipped.
+    int bench_suite(int argc, char** argv) {
+        namespace fs = std::filesystem;
+        std::string json_path, corpus_dir, ht_dir;
+        std::vector<OPJ_UINT32> sizes{ 64, 256, 1024 };
+        double min_mp = 4.0;
+        for (int i = 0; i + 1 < argc; i += 2) {
+            std::string key = argv[i], value = argv[i + 1];
+            if (key == "--json") json_path = value;
+            else if (key == "--corpus") corpus_dir = value;
+            else if (key == "--ht") ht_dir = value;
+            else if (key == "--min-mp") min_mp = std::max(0.01, atof(value.c_str()));
+            else if (key == "--sizes") {
+                sizes.clear();
+                for (const char* p = value.c_str(); *p;) {
+                    char* end = nullptr;
+                    unsigned long size = strtoul(p, &end, 10);
+                    if (end == p) break;
+                    if (size >= 8) sizes.push_back((OPJ_UINT32)size);
+                    p = *end ? end + 1 : end;
+                }
+            } else { fprintf(stderr, "suite: unknown option %s\n", key.c_str()); return 2; }
+        }
+        if (argc % 2) { fprintf(stderr, "suite: missing value for %s\n", argv[argc - 1]); return 2; }
+        if (sizes.empty()) { fprintf(stderr, "suite: no usable --sizes\n"); return 2; }
+        if (!corpus_dir.empty()) {
+            std::error_code ec;
+            fs::create_directories(fs::path(corpus_dir), ec);
+        }
+
+        struct Category {
+            std::string name;
+            OPJ_UINT32 size, comps;
+            EncodeOptions opts;
+            bool ht = false;
+            size_t classic = 0;             // index of the category holding source
+            std::vector<OPJ_BYTE> j2c;
+            opj_image_t* source = nullptr;
+        };
+        std::vector<Category> categories;
+        const OPJ_UINT32 comp_counts[] = { 1, 3, 4 };
+        for (OPJ_UINT32 size : sizes) {
+            for (OPJ_UINT32 comps : comp_counts) {
+                for (OPJ_UINT32 layers : { 1u, 5u }) {
+                    for (bool tiled : { false, true }) {
+                        for (bool lossless : { true, false }) {
+                            Category c;
+                            c.size = size;
+                            c.comps = comps;
+                            c.opts = EncodeOptions{ layers, lossless, tiled ? std::max(32u, size / 2) : 0, 1 };
+                            char name[64];
+                            snprintf(name, sizeof(name), "%ux%ux%u-L%u-%s-%s", size, size, comps, layers, tiled ? "tiled" : "untiled", lossless ? "lossless" : "lossy");
+                            c.name = name;
+                            categories.push_back(std::move(c));
+                        }
+                    }
+                }
+            }
+        }
+
+        // encode (seeded by category index, so every run produces identical bytes)
+        OPJ_UINT64 corpus_hash = 14695981039346656037ull;
+        size_t classic_count = categories.size();
+        for (size_t i = 0; i < classic_count; i++) {
+            Category& c = categories[i];
+            c.classic = i;
+            c.source = make_synthetic_image(c.size, c.size, c.comps, (OPJ_UINT32)i);
+            c.j2c = encode_j2c(c.source, c.opts);
+            if (c.j2c.empty()) { fprintf(stderr, "%s: encode failed\n", c.name.c_str()); return 1; }
+            corpus_hash = (corpus_hash ^ fnv1a(c.j2c)) * 1099511628211ull;
+            if (!corpus_dir.empty()) {
+                std::string path = (fs::path(corpus_dir) / (c.name + ".j2c")).string();
+                FILE* f = fopen(path.c_str(), "wb");
+                bool written = f && fwrite(c.j2c.data(), 1, c.j2c.size(), f) == c.j2c.size();
+                if (f) fclose(f);
+                if (!written) { fprintf(stderr, "%s: could not write\n", path.c_str()); return 1; }
+            }
+        }
+        size_t ht_missing = 0;
+        if (!ht_dir.empty()) {
+            for (size_t i = 0; i < classic_count; i++) {
+                Category ht = categories[i];
+                ht.j2c = read_file(fs::path(ht_dir) / (ht.name + ".j2c"));
+                if (ht.j2c.empty() || !isHTJ2K(ht.j2c.data(), ht.j2c.size())) { ht_missing++; continue; }
+                ht.name += "-ht";
+                ht.ht = true;
+                ht.source = nullptr; // owned by categories[ht.classic]
+                categories.push_back(std::move(ht));
+            }
+        }
+
+        DecoderContext* ctx = createDecoderContext(0);
+        struct Result { double mps = 0, ms = 0; OPJ_UINT64 decodes = 0, allocs = 0, allocBytes = 0; OPJ_INT64 peak = 0; bool exact = true; };
+        std::vector<Result> results(categories.size());
+        int status = 0;
+
+        printf("corpus %016llx, %zu categories, OpenJPEG %s, simd %s\n", (unsigned long long)corpus_hash, categories.size(), opj_version(), simdLevelName(simdLevel()));
+        printf("%-34s %9s %9s %9s %10s %12s %11s\n", "category", "bytes", "MP/s", "ms", "allocs", "alloc KB", "peak KB");
+        for (size_t i = 0; i < categories.size(); i++) {
+            Category const& c = categories[i];
+            Result& r = results[i];
+
+            // one measured decode: allocations and peak live heap above the baseline
+            AllocSnapshot before = alloc_begin();
+            opj_image_t* image = decode(ctx, c.j2c.data(), c.j2c.size());
+            r.allocs = allocs.count.load() - before.count;
+            r.allocBytes = allocs.bytes.load() - before.bytes;
+            r.peak = allocs.peak.load() - before.live;
+            if (!image) { fprintf(stderr, "%s: decode failed (%s)\n", c.name.c_str(), lastError(ctx).c_str()); status = 1; continue; }
+            if (c.opts.lossless && !same_pixels(image, categories[c.classic].source)) {
+                r.exact = false;
+                if (!c.ht) status = 1; // an HT transcode might not have been reversible
+                fprintf(stderr, "%s: lossless decode differs from the source image\n", c.name.c_str());
+            }
+            opj_image_destroy(image);
+
+            double mp = (double)c.size * c.size / 1e6;
+            r.decodes = (OPJ_UINT64)std::max(1.0, min_mp / mp);
+            auto start = steady::now();
+            for (OPJ_UINT64 n = 0; n < r.decodes; n++) opj_image_destroy(decode(ctx, c.j2c.data(), c.j2c.size()));
+            double seconds = elapsed_since(start);
+            r.mps = mp * r.decodes / seconds;
+            r.ms = seconds * 1e3 / r.decodes;
+            printf("%-34s %9zu %9.1f %9.3f %10llu %12.1f %11.1f\n", c.name.c_str(), c.j2c.size(), r.mps, r.ms,
+                (unsigned long long)r.allocs, r.allocBytes / 1024.0, r.peak / 1024.0);
+        }
+        if (ht_dir.empty()) printf("ht categories skipped (no --ht dir; see transcode_htj2k in improvise.bash)\n");
+        else if (ht_missing) printf("ht categories: %zu of %zu not found or not HTJ2K in %s\n", ht_missing, classic_count, ht_dir.c_str());
+
+        if (!json_path.empty()) {
+            FILE* out = json_path == "-" ? stdout : fopen(json_path.c_str(), "w");
+            if (!out) { fprintf(stderr, "%s: cannot write\n", json_path.c_str()); return 1; }
+            fprintf(out, "{\n  \"openjpeg\": \"%s\",\n  \"simd\": \"%s\",\n  \"corpusHash\": \"%016llx\",\n  \"minMegapixels\": %g,\n",
+                opj_version(), simdLevelName(simdLevel()), (unsigned long long)corpus_hash, min_mp);
+            if (ht_dir.empty()) fprintf(out, "  \"htSkipped\": \"no HTJ2K corpus (OpenJPEG has no HT encoder)\",\n");
+            fprintf(out, "  \"categories\": [\n");
+            for (size_t i = 0; i < categories.size(); i++) {
+                Category const& c = categories[i];
+                Result const& r = results[i];
+                fprintf(out, "    {\"name\": \"%s\", \"width\": %u, \"height\": %u, \"components\": %u, \"layers\": %u, \"tiled\": %s, "
+                             "\"lossless\": %s, \"ht\": %s, \"bytes\": %zu, \"hash\": \"%016llx\", \"decodes\": %llu, \"megapixelsPerSecond\": %.3f, "
+                             "\"msPerDecode\": %.4f, \"allocsPerDecode\": %llu, \"allocBytesPerDecode\": %llu, \"peakBytes\": %lld, \"exact\": %s}%s\n",
+                    c.name.c_str(), c.size, c.size, c.comps, c.opts.layers, c.opts.tile ? "true" : "false",
+                    c.opts.lossless ? "true" : "false", c.ht ? "true" : "false", c.j2c.size(), (unsigned long long)fnv1a(c.j2c),
+                    (unsigned long long)r.decodes, r.mps, r.ms, (unsigned long long)r.allocs, (unsigned long long)r.allocBytes,
+                    (long long)r.peak, r.exact ? "true" : "false", i + 1 < categories.size() ? "," : "");
+            }
+            fprintf(out, "  ]\n}\n");
+            if (out != stdout) fclose(out);
+        }
+
+        for (size_t i = 0; i < classic_count; i++) opj_image_destroy(categories[i].source);
+        destroyDecoderContext(ctx);
+        return status;
+    }
+
+    struct Mode {
+        const char* name;
+        const char* help;
+        std::function<int(int, char**)> run;
+    };
+
+    const Mode MODES[] = {
+        { "small", "[iterations]  small-texture decode throughput (fresh codec vs DecoderContext)", bench_small },
+        { "progressive", "[chunk bytes]  chunked arrival: full re-decode per chunk vs ProgressiveDecoder", bench_progressive },
+        { "batch", "[jobs]  burst of mixed decodes through DecodeScheduler (1..N workers, cancel/downgrade)", bench_batch },
+        { "simd", "[iterations]  inverse DWT/MCT kernels per SIMD level, bit-exactness vs the baseline build", bench_simd },
+        { "roi", "[iterations]  full-image vs quarter-area decodeArea() on tiled and untiled streams", bench_roi },
+        { "dump", "<in.j2c> <out prefix>  decode to PGM/PPM/TIFF for external transcoding", bench_dump },
+        { "ht", "<classic dir> <htj2k dir> [iterations]  decode speed and size of classic vs HTJ2K asset pairs", bench_ht },
+        { "encode", "[size] [iterations]  single vs multithreaded encode throughput, output must be byte-identical", bench_encode },
+        { "stream", "[count]  corpus load: fread vs mmap input, DecoderContext and file streams", bench_stream },
+        { "cache", "[assets] [requests]  skewed request trace: plain decode vs TextureCache, cold and next session", bench_cache },
+        { "suite", "[--json out.json] [--sizes 64,256,1024] [--min-mp 4] [--corpus dir] [--ht dir]  regression suite over a deterministic corpus", bench_suite },
+    };
+
+}} // namespace openjp2_api::bench
+
+int main(int argc, char** argv) {
+    using namespace openjp2_api::bench;
+    if (argc >= 2) {
+        for (Mode const& mode : MODES) {
+            if (!strcmp(argv[1], mode.name)) return mode.run(argc - 2, argv + 2);
+        }
+    }
+    fprintf(stderr, "usage: %s <mode> [args]\n", argc ? argv[0] : "openjp2_api_bench");
+    for (Mode const& mode : MODES) fprintf(stderr, "  %-12s %s\n", mode.name, mode.help);
+    return 2;
+}
@@ -0,0 +1,148 @@
+// openjp2_api lightweight J2C codestream marker parsing
+// copyright (c) 2026 humbletim
+//
+// Reads just enough of the main header (SIZ/COD/CAP) and the tile-part (SOT)
+// chain to make scheduling decisions without spinning up an OpenJPEG codec.
+// Works on truncated buffers; anything not yet received is reported as such.
+
+namespace openjp2_api {
+
+namespace {
+    enum : OPJ_UINT32 {
+        J2K_SOC = 0xFF4F, J2K_CAP = 0xFF50, J2K_SIZ = 0xFF51, J2K_COD = 0xFF52,
+        J2K_SOT = 0xFF90, J2K_EOC = 0xFFD9,
+    };
+    constexpr OPJ_UINT32 J2K_CBLKSTY_HT = 0x40;
+    constexpr OPJ_UINT32 PCAP_PART15 = 0x00020000; // Pcap bit for Part 15 (HTJ2K) -- ISO/IEC 15444-15 A.3
+
+    OPJ_UINT32 read_be(const OPJ_BYTE* p, int nbytes) {
+        OPJ_UINT32 v = 0;
+        for (int i = 0; i < nbytes; i++) v = (v << 8) | p[i];
+        return v;
+    }
+
+    OPJ_UINT32 ceildiv(OPJ_UINT32 a, OPJ_UINT32 b) {
+        return b ? (OPJ_UINT32)(((OPJ_UINT64)a + b - 1) / b) : 0;
+    }
+} // namespace
+
+namespace {
+    // calls visit(marker, segment, length) for every fully received main
+    // header marker segment; returns the offset of the first SOT (0 if not
+    // reached yet) or -1 on malformed data. visit returns false to abort.
+    template <typename Visit>
+    OPJ_INT64 walk_main_header(const OPJ_BYTE* data, OPJ_SIZE_T size, Visit&& visit) {
+        if (!data || size < 4 || read_be(data, 2) != J2K_SOC) return -1;
+        OPJ_SIZE_T pos = 2;
+        while (pos + 4 <= size) {
+            OPJ_UINT32 marker = read_be(data + pos, 2);
+            if (marker == J2K_SOT) return (OPJ_INT64)pos;
+            OPJ_UINT32 length = read_be(data + pos + 2, 2);
+            if ((marker & 0xFF00) != 0xFF00 || length < 2) return -1;
+            if (pos + 2 + length > size) break; // marker segment not fully received yet
+            if (!visit(marker, data + pos + 4, length)) return -1;
+            pos += 2 + length;
+        }
+        return 0;
+    }
+} // namespace
+
+bool parseCodestreamHeader(const OPJ_BYTE* data, OPJ_SIZE_T size, CodestreamInfo& info) {
+    info = CodestreamInfo{};
+    OPJ_INT64 sot = walk_main_header(data, size, [&info](OPJ_UINT32 marker, const OPJ_BYTE* seg, OPJ_UINT32 length) {
+        switch (marker) {
+        case J2K_SIZ: {
+            if (length < 38) return false;
+            info.x1 = read_be(seg + 2, 4);
+            info.y1 = read_be(seg + 6, 4);
+            info.x0 = read_be(seg + 10, 4);
+            info.y0 = read_be(seg + 14, 4);
+            info.tdx = read_be(seg + 18, 4);
+            info.tdy = read_be(seg + 22, 4);
+            info.tx0 = read_be(seg + 26, 4);
+            info.ty0 = read_be(seg + 30, 4);
+            OPJ_UINT32 numcomps = read_be(seg + 34, 2);
+            if (length < 38 + 3 * numcomps || !info.tdx || !info.tdy || info.x1 <= info.x0 || info.y1 <= info.y0) return false;
+            info.comps.resize(numcomps);
+            for (OPJ_UINT32 c = 0; c < numcomps; c++) {
+                const OPJ_BYTE* ssiz = seg + 36 + 3 * c;
+                info.comps[c].prec = (ssiz[0] & 0x7F) + 1;
+                info.comps[c].sgnd = (ssiz[0] & 0x80) != 0;
+                info.comps[c].dx = ssiz[1];
+                info.comps[c].dy = ssiz[2];
+            }
+            info.numTilesX = ceildiv(info.x1 - info.tx0, info.tdx);
+            info.numTilesY = ceildiv(info.y1 - info.ty0, info.tdy);
+            info.valid = true;
+            break;
+        }
+        case J2K_COD:
+            if (length < 12) return false;
+            info.progression = (OPJ_PROG_ORDER)seg[1];
+            info.numlayers = read_be(seg + 2, 2);
+            info.mct = seg[4] != 0;
+            info.numresolutions = seg[5] + 1u;
+            info.cblkStyle = seg[8];
+            info.reversible = seg[9] == 1;
+            info.htj2k = info.htj2k || (info.cblkStyle & J2K_CBLKSTY_HT) != 0;
+            break;
+        case J2K_CAP:
+            if (length >= 6 && (read_be(seg, 4) & PCAP_PART15)) info.htj2k = true;
+            break;
+        default:
+            break;
+        }
+        return true;
+    });
+    if (sot < 0) {
+        info.valid = false;
+        return false;
+    }
+    if (sot > 0) {
+        info.headerComplete = info.valid;
+        info.headerSize = (OPJ_SIZE_T)sot;
+    }
+    return info.valid;
+}
+
+bool isHTJ2K(const OPJ_BYTE* data, OPJ_SIZE_T size) {
+    bool ht = false;
+    walk_main_header(data, size, [&ht](OPJ_UINT32 marker, const OPJ_BYTE* seg, OPJ_UINT32 length) {
+        if (marker == J2K_CAP && length >= 6 && (read_be(seg, 4) & PCAP_PART15)) ht = true;
+        if (marker == J2K_COD && length >= 12 && (seg[8] & J2K_CBLKSTY_HT)) ht = true;
+        return !ht;
+    });
+    return ht;
+}
+
+OPJ_SIZE_T scanTileParts(const OPJ_BYTE* data, OPJ_SIZE_T size, OPJ_SIZE_T offset, std::vector<TilePart>& out, bool* eoc) {
+    if (eoc) *eoc = false;
+    while (offset + 12 <= size) {
+        OPJ_UINT32 marker = read_be(data + offset, 2);
+        if (marker == J2K_EOC) {
+            if (eoc) *eoc = true;
+            break;
+        }
+        if (marker != J2K_SOT) break; // corrupt or not a tile-part boundary
+        TilePart tp;
+        tp.offset = offset;
+        tp.tileIndex = read_be(data + offset + 4, 2);
+        tp.length = read_be(data + offset + 6, 4);
+        tp.partIndex = data[offset + 10];
+        tp.numParts = data[offset + 11];
+        if (tp.length == 0) {
+            // Psot == 0: last tile-part, extends to EOC
+            tp.length = (OPJ_UINT32)(size - offset);
+            tp.complete = size >= 2 && read_be(data + size - 2, 2) == J2K_EOC;
+            if (tp.complete) tp.length -= 2;
+        } else {
+            tp.complete = offset + tp.length <= size;
+        }
+        if (!tp.complete) break; // rescan from here once more bytes arrive
+        out.push_back(tp);
+        offset += tp.length;
+    }
+    return offset;
+}
+
+} // namespace openjp2_api
@@ -0,0 +1,169 @@
+// openjp2_api reusable decoder contexts
+// copyright (c) 2026 humbletim
+//
+// OpenJPEG's public API assumes one opj_codec_t + opj_stream_t + thread pool per
+// decode. For the many tiny textures the viewer fetches (icons, 64x64 sculpt
+// maps) that setup (1MB default stream buffer, thread pool + TLS, T1 scratch
+// allocation) costs more than the actual wavelet decode. Since this module is
+// compiled as part of the amalgamation, the private structs are visible and the
+// expensive parts can be kept alive per thread and swapped into each new codec.
+//
+// note: the codec object itself is still created per decode -- j2k header and
+// tile state isn't designed to be reset and that part is cheap anyway.
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <memory>
+
+namespace openjp2_api {
+
+namespace {
+    void record_error(const char* msg, void* user_data) {
+        auto* error = static_cast<std::string*>(user_data);
+        error->assign(msg ? msg : "");
+        while (!error->empty() && error->back() == '\n') error->pop_back();
+    }
+
+    opj_j2k_t* codec_j2k(opj_codec_t* codec, OPJ_CODEC_FORMAT format) {
+        auto* priv = reinterpret_cast<opj_codec_private_t*>(codec);
+        if (format == OPJ_CODEC_JP2) {
+            return static_cast<opj_jp2_t*>(priv->m_codec)->j2k;
+        }
+        return static_cast<opj_j2k_t*>(priv->m_codec);
+    }
+} // namespace
+
+struct DecoderContext {
+    opj_thread_pool_t* mThreadPool = nullptr;
+    opj_stream_t* mStream = nullptr;
+    SpanSource mSource;
+    DecoderStats mStats;
+    std::string mLastError;
+
+    ~DecoderContext() {
+        if (mStream) {
+            span_release(&mSource);
+            opj_stream_destroy(mStream);
+        }
+        if (mThreadPool) opj_thread_pool_destroy(mThreadPool);
+    }
+
+    // creates a codec borrowing this context's thread pool
+    opj_codec_t* acquireCodec(OPJ_CODEC_FORMAT format) {
+        opj_codec_t* codec = opj_create_decompress(format);
+        if (!codec) return nullptr;
+        opj_j2k_t* j2k = codec_j2k(codec, format);
+        opj_thread_pool_destroy(j2k->m_tp);
+        j2k->m_tp = mThreadPool;
+        opj_set_error_handler(codec, record_error, &mLastError);
+        return codec;
+    }
+
+    // hands the thread pool back before the codec gets a chance to destroy it
+    void releaseCodec(opj_codec_t* codec, OPJ_CODEC_FORMAT format) {
+        if (!codec) return;
+        codec_j2k(codec, format)->m_tp = nullptr;
+        opj_destroy_codec(codec);
+    }
+
+    // re-points the span stream at a new codestream (see openjp2_api.stream.c++)
+    opj_stream_t* attachStream(const OPJ_BYTE* data, OPJ_SIZE_T size) {
+        span_attach(&mSource, data, size);
+        return mStream;
+    }
+
+    using DecodeStep = std::function<bool(opj_codec_t*, opj_stream_t*, opj_image_t*)>;
+
+    // shared driver: codec/stream setup + header, then the caller's decode step
+    // (full decode, single tile, area...), with stats and error bookkeeping
+    opj_image_t* run(const OPJ_BYTE* data, OPJ_SIZE_T size, DecodeParams const& params, DecodeStep const& step);
+};
+
+DecoderContext* createDecoderContext(int num_threads) {
+    auto ctx = std::make_unique<DecoderContext>();
+    ctx->mThreadPool = opj_thread_pool_create(opj_has_thread_support() ? std::max(num_threads, 0) : 0);
+    ctx->mStream = opj_stream_create(1, OPJ_TRUE); // the buffer is replaced by each attached codestream
+    if (!ctx->mThreadPool || !ctx->mStream) return nullptr;
+    span_install(ctx->mStream, &ctx->mSource);
+    return ctx.release();
+}
+
+void destroyDecoderContext(DecoderContext* ctx) {
+    delete ctx;
+}
+
+DecoderContext* threadDecoderContext() {
+    thread_local std::unique_ptr<DecoderContext, void(*)(DecoderContext*)> tls_ctx{ createDecoderContext(0), destroyDecoderContext };
+    return tls_ctx.get();
+}
+
+opj_image_t* DecoderContext::run(const OPJ_BYTE* data, OPJ_SIZE_T size, DecodeParams const& params, DecodeStep const& step) {
+    if (!data || !size) return nullptr;
+    auto start = std::chrono::steady_clock::now();
+    mLastError.clear();
+
+    opj_codec_t* codec = acquireCodec(params.format);
+    opj_stream_t* stream = attachStream(data, size);
+    opj_image_t* image = nullptr;
+
+    opj_dparameters_t dparams;
+    opj_set_default_decoder_parameters(&dparams);
+    dparams.cp_reduce = params.reduce;
+    dparams.cp_layer = params.layers;
+
+    bool ok = codec
+        && opj_setup_decoder(codec, &dparams)
+        && opj_decoder_set_strict_mode(codec, params.strict ? OPJ_TRUE : OPJ_FALSE)
+        && opj_read_header(stream, codec, &image)
+        && step(codec, stream, image);
+
+    releaseCodec(codec, params.format);
+
+    mStats.decodes++;
+    mStats.bytes += size;
+    if (!ok) {
+        mStats.failures++;
+        if (mLastError.empty()) mLastError = "opj_decode failed";
+        if (image) opj_image_destroy(image);
+        image = nullptr;
+    } else {
+        if (image->numcomps) mStats.pixels += (OPJ_UINT64)image->comps[0].w * image->comps[0].h;
+        if (params.format == OPJ_CODEC_J2K && isHTJ2K(data, size)) mStats.htDecodes++;
+    }
+    mStats.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return image;
+}
+
+opj_image_t* decode(DecoderContext* ctx, const OPJ_BYTE* data, OPJ_SIZE_T size, DecodeParams const& params) {
+    if (!ctx) return nullptr;
+    return ctx->run(data, size, params, [](opj_codec_t* codec, opj_stream_t* stream, opj_image_t* image) {
+        return opj_decode(codec, stream, image) && opj_end_decompress(codec, stream);
+    });
+}
+
+opj_image_t* decodeArea(DecoderContext* ctx, const OPJ_BYTE* data, OPJ_SIZE_T size, DecodeArea const& area, DecodeParams const& params) {
+    if (!ctx) return nullptr;
+    return ctx->run(data, size, params, [ctx, &area](opj_codec_t* codec, opj_stream_t* stream, opj_image_t* image) {
+        OPJ_UINT32 x0 = std::max(area.x0, image->x0), y0 = std::max(area.y0, image->y0);
+        OPJ_UINT32 x1 = std::min(area.x1, image->x1), y1 = std::min(area.y1, image->y1);
+        if (x0 >= x1 || y0 >= y1) {
+            ctx->mLastError = "decode area does not intersect the image";
+            return false;
+        }
+        return opj_set_decode_area(codec, image, (OPJ_INT32)x0, (OPJ_INT32)y0, (OPJ_INT32)x1, (OPJ_INT32)y1)
+            && opj_decode(codec, stream, image)
+            && opj_end_decompress(codec, stream);
+    });
+}
+
+DecoderStats const& stats(DecoderContext const* ctx) {
+    return ctx->mStats;
+}
+
+std::string const& lastError(DecoderContext const* ctx) {
+    return ctx->mLastError;
+}
+
+} // namespace openjp2_api
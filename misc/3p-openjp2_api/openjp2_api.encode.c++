@@ -0,0 +1,87 @@
+// openjp2_api in-memory, multithreaded encoding
+// copyright (c) 2026 humbletim
+//
+// Texture uploads and snapshots used to encode on a single thread. OpenJPEG
+// 2.5 can already run T1 (the MQ coder, by far the dominant cost) across a
+// thread pool -- one job per code-block, tiles included -- while packet
+// assembly and rate allocation stay on the calling thread. This wraps that
+// with an in-memory sink so callers get the codestream bytes directly.
+//
+// note: splicing independently encoded tiles into one codestream was
+// considered, but code-block jobs already spread evenly over untiled images
+// and keep the output identical to the single-threaded encoder.
+
+#include <thread>
+
+namespace openjp2_api {
+
+namespace {
+    // output staging buffer; encoded tiles are flushed through it in chunks
+    constexpr OPJ_SIZE_T STREAM_BUFFER_SIZE = 64 * 1024;
+} // namespace
+
+// growable in-memory output for opj_stream_t
+struct MemorySink {
+    std::vector<OPJ_BYTE> bytes;
+    OPJ_SIZE_T offset = 0;
+
+    static OPJ_SIZE_T write(void* buffer, OPJ_SIZE_T nb_bytes, void* user_data) {
+        auto* sink = static_cast<MemorySink*>(user_data);
+        if (sink->offset + nb_bytes > sink->bytes.size()) sink->bytes.resize(sink->offset + nb_bytes);
+        memcpy(sink->bytes.data() + sink->offset, buffer, nb_bytes);
+        sink->offset += nb_bytes;
+        return nb_bytes;
+    }
+    static OPJ_OFF_T skip(OPJ_OFF_T nb_bytes, void* user_data) {
+        auto* sink = static_cast<MemorySink*>(user_data);
+        sink->offset += nb_bytes;
+        if (sink->offset > sink->bytes.size()) sink->bytes.resize(sink->offset);
+        return nb_bytes;
+    }
+    static OPJ_BOOL seek(OPJ_OFF_T nb_bytes, void* user_data) {
+        auto* sink = static_cast<MemorySink*>(user_data);
+        sink->offset = (OPJ_SIZE_T)nb_bytes;
+        if (sink->offset > sink->bytes.size()) sink->bytes.resize(sink->offset);
+        return OPJ_TRUE;
+    }
+};
+
+std::vector<OPJ_BYTE> encode(opj_image_t* image, opj_cparameters_t const& params, int num_threads, OPJ_CODEC_FORMAT format, std::string* error) {
+    std::string message;
+    if (!error) error = &message;
+    error->clear();
+    if (!image) return {};
+    if (num_threads <= 0) num_threads = (int)std::max(1u, std::thread::hardware_concurrency());
+
+    opj_cparameters_t cp = params; // opj_setup_encoder wants it mutable
+    MemorySink sink;
+    opj_codec_t* codec = opj_create_compress(format);
+    opj_stream_t* stream = opj_stream_create(STREAM_BUFFER_SIZE, OPJ_FALSE);
+    if (!codec || !stream) {
+        if (stream) opj_stream_destroy(stream);
+        if (codec) opj_destroy_codec(codec);
+        *error = "out of memory";
+        return {};
+    }
+    opj_set_error_handler(codec, record_error, error);
+    opj_stream_set_write_function(stream, MemorySink::write);
+    opj_stream_set_skip_function(stream, MemorySink::skip);
+    opj_stream_set_seek_function(stream, MemorySink::seek);
+    opj_stream_set_user_data(stream, &sink, nullptr);
+
+    bool ok = opj_setup_encoder(codec, &cp, image)
+        && (num_threads == 1 || !opj_has_thread_support() || opj_codec_set_threads(codec, num_threads))
+        && opj_start_compress(codec, image, stream)
+        && opj_encode(codec, stream)
+        && opj_end_compress(codec, stream);
+
+    opj_stream_destroy(stream);
+    opj_destroy_codec(codec);
+    if (!ok) {
+        if (error->empty()) *error = "opj_encode failed";
+        return {};
+    }
+    return std::move(sink.bytes);
+}
+
+} // namespace openjp2_api
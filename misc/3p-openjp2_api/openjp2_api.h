@@ -23,8 +23,14 @@
 #pragma message("hi there OPJ_STATIC")
   #define OPJ_STATIC
   #define OPJ_PACKAGE_VERSION "2.5.3"  
+#ifdef _WIN32
   #define OPJ_HAVE__ALIGNED_MALLOC 1  
   #define MUTEX_win32 1  
+#else
+  // (non-windows is only used for building the standalone openjp2_api.bench.c++ tooling)
+  #define OPJ_HAVE_POSIX_MEMALIGN 1
+  #define MUTEX_pthread 1
+#endif
   #define OPJ_VERSION_MAJOR 2
   #define OPJ_VERSION_MINOR 5
   #define OPJ_VERSION_BUILD 3
@@ -33,6 +39,279 @@
   #pragma include_alias("opj_config.h", "openjpeg/src/lib/openjp2/openjpeg.h")
   #pragma include_alias("opj_config_private.h", "openjpeg/src/lib/openjp2/openjpeg.h")
   #include "openjpeg/src/lib/openjp2/openjpeg.h"
+
+// ---------------------------------------------------------------------------
+// openjp2_api extensions (C++ only; see openjp2_api.*.c++ for implementations)
+#ifdef __cplusplus
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace openjp2_api {
+
+    struct DecodeParams {
+        OPJ_CODEC_FORMAT format = OPJ_CODEC_J2K;
+        OPJ_UINT32 reduce = 0;   // discard level (resolution reduction factor)
+        OPJ_UINT32 layers = 0;   // max quality layers to decode (0 == all)
+        bool strict = false;     // false allows truncated codestreams
+    };
+
+    struct DecoderStats {
+        OPJ_UINT64 decodes = 0;
+        OPJ_UINT64 failures = 0;
+        OPJ_UINT64 bytes = 0;
+        OPJ_UINT64 pixels = 0;
+        OPJ_UINT64 htDecodes = 0; // subset of decodes that were HTJ2K (Part 15) codestreams
+        double seconds = 0.0;
+    };
+
+    // Decoder state kept alive across decodes on the same thread: the OpenJPEG
+    // thread pool (and with it the per-thread T1 code-block scratch buffers)
+    // plus a span input stream re-pointed at each codestream. A context must only
+    // be used by one thread at a time.
+    struct DecoderContext;
+
+    DecoderContext* createDecoderContext(int num_threads = 0);
+    void destroyDecoderContext(DecoderContext* ctx);
+
+    // lazily-created context owned by (and destroyed with) the calling thread
+    DecoderContext* threadDecoderContext();
+
+    // decodes a complete in-memory codestream; caller owns the returned image
+    // (opj_image_destroy); returns nullptr on failure (see lastError)
+    opj_image_t* decode(DecoderContext* ctx, const OPJ_BYTE* data, OPJ_SIZE_T size, DecodeParams const& params = {});
+
+    // rectangle on the reference grid, i.e. full-resolution image coordinates
+    // (x1/y1 exclusive); clamped to the image area when decoding
+    struct DecodeArea {
+        OPJ_UINT32 x0 = 0, y0 = 0, x1 = 0, y1 = 0;
+    };
+
+    // decodes only the code-blocks (and with them only the tiles) that
+    // contribute to area, at the resolution selected by params.reduce; the
+    // returned image covers just that area (component x0/y0 tell where)
+    opj_image_t* decodeArea(DecoderContext* ctx, const OPJ_BYTE* data, OPJ_SIZE_T size, DecodeArea const& area, DecodeParams const& params = {});
+
+    DecoderStats const& stats(DecoderContext const* ctx);
+    std::string const& lastError(DecoderContext const* ctx);
+
+    // --- input streams ---
+
+    // seekable input stream reading straight out of [data, data + size) -- no
+    // staging buffer, no read callback copies. data must outlive the stream
+    // (opj_stream_destroy).
+    opj_stream_t* createSpanStream(const OPJ_BYTE* data, OPJ_SIZE_T size);
+
+    // read-only memory mapping of a whole file (path is UTF-8)
+    struct MappedFile;
+
+    MappedFile* mapFile(const char* path);  // nullptr if missing, empty or unmappable
+    void unmapFile(MappedFile* file);
+    const OPJ_BYTE* mappedData(MappedFile const* file);
+    OPJ_SIZE_T mappedSize(MappedFile const* file);
+
+    // span stream over a mapping it owns (unmapped by opj_stream_destroy);
+    // drop-in replacement for opj_stream_create_default_file_stream(path, OPJ_TRUE)
+    opj_stream_t* createMappedFileStream(const char* path);
+
+    // --- raw codestream inspection (no codec involved) ---
+
+    struct CodestreamInfo {
+        bool valid = false;           // SIZ seen
+        bool headerComplete = false;  // main header fully present (first SOT reached)
+        OPJ_SIZE_T headerSize = 0;    // byte offset of the first SOT
+        OPJ_UINT32 x0 = 0, y0 = 0, x1 = 0, y1 = 0;      // image area on the reference grid
+        OPJ_UINT32 tx0 = 0, ty0 = 0, tdx = 0, tdy = 0;  // tile grid origin and size
+        OPJ_UINT32 numTilesX = 0, numTilesY = 0;
+        struct Component { OPJ_UINT32 prec = 0; bool sgnd = false; OPJ_UINT32 dx = 1, dy = 1; };
+        std::vector<Component> comps;
+        OPJ_UINT32 numlayers = 0;
+        OPJ_UINT32 numresolutions = 0;
+        OPJ_UINT32 cblkStyle = 0;
+        OPJ_PROG_ORDER progression = OPJ_PROG_UNKNOWN;
+        bool mct = false;
+        bool reversible = false;
+        bool htj2k = false;           // Part 15 (CAP marker or HT code-block style)
+    };
+
+    struct TilePart {
+        OPJ_SIZE_T offset = 0;        // of the SOT marker
+        OPJ_UINT32 tileIndex = 0;
+        OPJ_UINT32 length = 0;        // Psot (resolved when 0 == "until EOC")
+        OPJ_UINT32 partIndex = 0;
+        OPJ_UINT32 numParts = 0;      // 0 == not signalled in this tile-part
+        bool complete = false;
+    };
+
+    // returns false until SIZ has been received (or on a malformed header)
+    bool parseCodestreamHeader(const OPJ_BYTE* data, OPJ_SIZE_T size, CodestreamInfo& info);
+
+    // true for HTJ2K (Part 15) codestreams -- CAP marker or HT code-block style
+    // in the main header; these decode through ht_dec.c instead of t1.c
+    bool isHTJ2K(const OPJ_BYTE* data, OPJ_SIZE_T size);
+
+    // appends every fully-received tile-part starting at offset (normally a
+    // previous return value, initially info.headerSize); returns the offset to
+    // resume from once more bytes are available
+    OPJ_SIZE_T scanTileParts(const OPJ_BYTE* data, OPJ_SIZE_T size, OPJ_SIZE_T offset, std::vector<TilePart>& out, bool* eoc = nullptr);
+
+    // --- progressive decoding of a codestream that arrives in chunks ---
+
+    struct ProgressiveOptions {
+        DecodeParams params;          // applied to every decode
+        double redecodeGrowth = 1.5;  // bytes must grow by this factor between partial decodes
+        OPJ_SIZE_T expectedSize = 0;  // full asset size if known (0 == rely on EOC)
+    };
+
+    struct ProgressiveStatus {
+        bool headerParsed = false;
+        bool complete = false;        // every tile decoded from its final bytes
+        OPJ_SIZE_T bytes = 0;
+        OPJ_UINT32 tiles = 0;
+        OPJ_UINT32 tilesFinal = 0;    // tiles decoded once from complete data
+        OPJ_UINT32 tileDecodes = 0;
+        OPJ_UINT32 partialDecodes = 0;
+        OPJ_UINT32 skippedUpdates = 0; // decodeAvailable calls that had nothing worth decoding
+    };
+
+    // Accumulates codestream bytes and keeps a composite image that is refined
+    // as they arrive: the main header is parsed once, tiles whose tile-parts
+    // are all present are decoded exactly once and never touched again, and
+    // only the still-incomplete region is re-decoded (rate limited by
+    // redecodeGrowth). Not thread safe.
+    struct ProgressiveDecoder;
+
+    // ctx may be nullptr to use threadDecoderContext() of the calling thread
+    ProgressiveDecoder* createProgressiveDecoder(ProgressiveOptions const& options = {}, DecoderContext* ctx = nullptr);
+    void destroyProgressiveDecoder(ProgressiveDecoder* dec);
+
+    void appendBytes(ProgressiveDecoder* dec, const OPJ_BYTE* data, OPJ_SIZE_T size);
+
+    // decodes whatever became useful since the last call; the returned image is
+    // owned by the decoder and stays valid until the next call or destruction
+    // (nullptr until the main header is available). *updated reports whether
+    // any pixels changed.
+    const opj_image_t* decodeAvailable(ProgressiveDecoder* dec, bool* updated = nullptr);
+
+    ProgressiveStatus const& progressStatus(ProgressiveDecoder const* dec);
+    CodestreamInfo const& codestreamInfo(ProgressiveDecoder const* dec);
+
+    // --- batch decode service ---
+
+    typedef OPJ_UINT64 DecodeJobId;
+
+    struct DecodeResult {
+        enum Status { DONE, FAILED, CANCELLED };
+        DecodeJobId id = 0;
+        Status status = FAILED;
+        opj_image_t* image = nullptr; // owned by the receiver (opj_image_destroy)
+        OPJ_UINT32 reduce = 0;        // discard level actually decoded (after any downgrade)
+        double queueSeconds = 0.0;    // submit -> decode start
+        double decodeSeconds = 0.0;
+        std::string error;
+    };
+
+    struct DecodeRequest {
+        const OPJ_BYTE* data = nullptr;
+        OPJ_SIZE_T size = 0;
+        std::shared_ptr<const void> keepAlive; // optional owner of data, released once the job retires
+        DecodeParams params;
+        float importance = 0.f;        // e.g. on-screen area; higher runs first
+        std::function<void(DecodeResult&&)> onComplete; // invoked on a worker (or on the cancel() caller)
+    };
+
+    struct SchedulerStats {
+        OPJ_UINT64 submitted = 0, completed = 0, failed = 0, cancelled = 0, downgraded = 0, stolen = 0;
+        OPJ_UINT64 pixels = 0;
+        double queueSecondsTotal = 0.0, queueSecondsMax = 0.0;
+        double decodeSecondsTotal = 0.0;
+        double wallSeconds = 0.0;      // since the first submit after creation / resetStats
+    };
+
+    // Fixed pool of decode workers, each with its own priority queue and
+    // DecoderContext; idle workers steal the best job from their peers.
+    // Ordering: importance, then higher discard level (cheaper, gets something
+    // on screen sooner), then submission order. Queued jobs can be cancelled,
+    // downgraded to a coarser discard level or re-prioritized until a worker
+    // picks them up.
+    struct DecodeScheduler;
+
+    DecodeScheduler* createDecodeScheduler(int num_workers = 0); // 0 == hardware concurrency
+    void destroyDecodeScheduler(DecodeScheduler* sched);          // cancels whatever is still queued
+
+    DecodeJobId submit(DecodeScheduler* sched, DecodeRequest request);
+    bool cancel(DecodeScheduler* sched, DecodeJobId id);
+    bool downgrade(DecodeScheduler* sched, DecodeJobId id, OPJ_UINT32 reduce);
+    bool reprioritize(DecodeScheduler* sched, DecodeJobId id, float importance);
+
+    void waitIdle(DecodeScheduler* sched);
+    SchedulerStats stats(DecodeScheduler const* sched);
+    void resetStats(DecodeScheduler* sched);
+
+    // --- encoding ---
+
+    // encodes image into an in-memory codestream. T1 (code-block) coding runs
+    // on num_threads workers (0 == hardware concurrency, 1 == single-threaded)
+    // and T2/rate allocation stays serial, so the output is byte-identical for
+    // any thread count (except fixed-quality/tcp_distoratio allocation, whose
+    // float distortion sums depend on completion order). Returns an empty
+    // vector on failure (see error).
+    std::vector<OPJ_BYTE> encode(opj_image_t* image, opj_cparameters_t const& params, int num_threads = 0,
+                                 OPJ_CODEC_FORMAT format = OPJ_CODEC_J2K, std::string* error = nullptr);
+
+    // --- decoded texture cache ---
+
+    struct TextureCacheOptions {
+        std::string directory;                 // UTF-8; created if missing
+        OPJ_UINT64 maxBytes = 512ull << 20;    // least recently used entries are evicted beyond this
+    };
+
+    struct TextureCacheStats {
+        OPJ_UINT64 hits = 0, misses = 0, stores = 0, evictions = 0;
+        OPJ_UINT64 rejected = 0;               // unreadable / stale entries dropped on lookup (counted as misses too)
+        OPJ_UINT64 entries = 0, bytes = 0;     // current contents
+        double loadSeconds = 0.0;              // spent serving hits
+        double decodeSeconds = 0.0;            // spent decoding + storing misses (decodeCached)
+    };
+
+    // On-disk cache of decoded images keyed by asset UUID and discard level.
+    // Entries hold the raw samples (1/2/4 bytes each depending on precision)
+    // and are memory-mapped on lookup, so hits skip the codestream entirely.
+    // Bounded by maxBytes with LRU eviction; recency persists across sessions.
+    // Thread safe.
+    struct TextureCache;
+
+    TextureCache* createTextureCache(TextureCacheOptions const& options); // picks up existing entries
+    void destroyTextureCache(TextureCache* cache);
+
+    // caller owns the returned image; sourceSize (the codestream length, if
+    // known) guards against entries decoded from a different codestream
+    opj_image_t* loadCached(TextureCache* cache, std::string const& uuid, OPJ_UINT32 discard, OPJ_UINT64 sourceSize = 0);
+    bool storeCached(TextureCache* cache, std::string const& uuid, OPJ_UINT32 discard, opj_image_t const* image, OPJ_UINT64 sourceSize = 0);
+
+    // loadCached() at params.reduce, else decode() and store the result.
+    // Layer-limited decodes (params.layers != 0) bypass the cache.
+    opj_image_t* decodeCached(TextureCache* cache, DecoderContext* ctx, std::string const& uuid,
+                              const OPJ_BYTE* data, OPJ_SIZE_T size, DecodeParams const& params = {});
+
+    TextureCacheStats stats(TextureCache const* cache);
+    void resetStats(TextureCache* cache);  // keeps entries/bytes
+
+    // --- SIMD kernels (inverse DWT 5/3 + 9/7, inverse RCT + ICT) ---
+
+    // x86/x64 only; elsewhere everything reports SIMD_BASELINE
+    // (the target's own build of dwt.c/mct.c: SSE2 on x64, not scalar)
+    enum SimdLevel { SIMD_BASELINE, SIMD_SSE41, SIMD_AVX2 };
+
+    SimdLevel detectedSimdLevel();            // best level the CPU + OS support
+    SimdLevel simdLevel();                    // active level (env OPENJP2_API_SIMD=baseline|sse41|avx2 caps the default)
+    SimdLevel setSimdLevel(SimdLevel level);  // clamped to detectedSimdLevel(); returns the now active level
+    const char* simdLevelName(SimdLevel level);
+
+} // namespace openjp2_api
+#endif // __cplusplus
+
 #endif // OPENJP2_API_H
 
 // ===========================================================================
@@ -49,7 +328,51 @@
 #include "openjpeg/src/lib/openjp2/thread.c"  
 #include "openjpeg/src/lib/openjp2/bio.c"  
 #include "openjpeg/src/lib/openjp2/cio.c"  
+
+/* dwt.c + mct.c: baseline build here, renamed so openjp2_api.simd.c++ can
+   add SSE4.1/AVX2 builds of the same sources and dispatch between them.
+   Only the feature macros above the target's baseline are hidden: on x64
+   __SSE__/__SSE2__ stay, so the routines that are not dispatched (the
+   forward DWT and MCT used by the encoder) keep their SSE2 paths. MSVC
+   never defines them, so they are supplied where SSE2 is its baseline */
+#if !defined(OPENJP2_API_SIMD_DISPATCH) && (defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86))
+  #define OPENJP2_API_SIMD_DISPATCH 1
+#endif
+#if OPENJP2_API_SIMD_DISPATCH
+  #pragma push_macro("__SSE__")
+  #pragma push_macro("__SSE2__")
+  #pragma push_macro("__SSSE3__")
+  #pragma push_macro("__SSE4_1__")
+  #pragma push_macro("__AVX__")
+  #pragma push_macro("__AVX2__")
+  #if defined(_MSC_VER) && !defined(__SSE2__) && (defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+    #define __SSE__ 1
+    #define __SSE2__ 1
+  #endif
+  #undef __SSSE3__
+  #undef __SSE4_1__
+  #undef __AVX__
+  #undef __AVX2__
+  #define opj_dwt_decode opj_dwt_decode_baseline
+  #define opj_dwt_decode_real opj_dwt_decode_real_baseline
+  #define opj_mct_decode opj_mct_decode_baseline
+  #define opj_mct_decode_real opj_mct_decode_real_baseline
+#endif
 #include "openjpeg/src/lib/openjp2/dwt.c"  
+#include "openjpeg/src/lib/openjp2/mct.c"  
+#if OPENJP2_API_SIMD_DISPATCH
+  #undef opj_dwt_decode
+  #undef opj_dwt_decode_real
+  #undef opj_mct_decode
+  #undef opj_mct_decode_real
+  #pragma pop_macro("__SSE__")
+  #pragma pop_macro("__SSE2__")
+  #pragma pop_macro("__SSSE3__")
+  #pragma pop_macro("__SSE4_1__")
+  #pragma pop_macro("__AVX__")
+  #pragma pop_macro("__AVX2__")
+#endif
+
 #include "openjpeg/src/lib/openjp2/event.c"  
 #define opj_t1_allocate_buffers opj_ht_t1_allocate_buffers  
 #include "openjpeg/src/lib/openjp2/ht_dec.c"  
@@ -58,7 +381,6 @@
 #include "openjpeg/src/lib/openjp2/invert.c"  
 #include "openjpeg/src/lib/openjp2/j2k.c"  
 #include "openjpeg/src/lib/openjp2/jp2.c"  
-#include "openjpeg/src/lib/openjp2/mct.c"  
 #include "openjpeg/src/lib/openjp2/mqc.c"  
 #include "openjpeg/src/lib/openjp2/openjpeg.c"  
 #include "openjpeg/src/lib/openjp2/opj_clock.c"  
@@ -68,7 +390,45 @@
 #include "openjpeg/src/lib/openjp2/tcd.c"  
 #include "openjpeg/src/lib/openjp2/tgt.c"  
 #include "openjpeg/src/lib/openjp2/function_list.c"  
+/* opj_malloc.c: in benchmark builds the allocator entry points are renamed so
+   openjp2_api.bench.c++ can wrap them with allocation accounting */
+#ifdef OPENJP2_API_BENCHMARK
+  #define opj_malloc opj_malloc_untracked
+  #define opj_calloc opj_calloc_untracked
+  #define opj_realloc opj_realloc_untracked
+  #define opj_free opj_free_untracked
+  #define opj_aligned_malloc opj_aligned_malloc_untracked
+  #define opj_aligned_realloc opj_aligned_realloc_untracked
+  #define opj_aligned_32_malloc opj_aligned_32_malloc_untracked
+  #define opj_aligned_32_realloc opj_aligned_32_realloc_untracked
+  #define opj_aligned_free opj_aligned_free_untracked
+#endif
 #include "openjpeg/src/lib/openjp2/opj_malloc.c"  
+#ifdef OPENJP2_API_BENCHMARK
+  #undef opj_malloc
+  #undef opj_calloc
+  #undef opj_realloc
+  #undef opj_free
+  #undef opj_aligned_malloc
+  #undef opj_aligned_realloc
+  #undef opj_aligned_32_malloc
+  #undef opj_aligned_32_realloc
+  #undef opj_aligned_free
+#endif
 #include "openjpeg/src/lib/openjp2/sparse_array.c"
 
+/* openjp2_api extensions */
+#include "openjp2_api.stream.c++"
+#include "openjp2_api.decoder_context.c++"
+#include "openjp2_api.codestream.c++"
+#include "openjp2_api.progressive.c++"
+#include "openjp2_api.scheduler.c++"
+#include "openjp2_api.simd.c++"
+#include "openjp2_api.encode.c++"
+#include "openjp2_api.texture_cache.c++"
+
+#ifdef OPENJP2_API_BENCHMARK
+#include "openjp2_api.bench.c++"
+#endif
+
 #endif // OPENVR_API_IMPLEMENTATION
@@ -0,0 +1,249 @@
+// openjp2_api progressive decoding of partially received codestreams
+// copyright (c) 2026 humbletim
+//
+// The viewer fetches textures in ranges and used to re-decode the whole
+// buffer from byte zero every time a range landed. OpenJPEG cannot suspend
+// and resume T1/T2 state mid-codestream, so instead this keeps everything
+// that *can* be retained between arrivals:
+//  - the main header is parsed once (and tile-part boundaries are scanned
+//    incrementally, without a codec)
+//  - a tile is decoded exactly once, as soon as all of its tile-parts are in,
+//    and blitted into a composite image that persists across updates
+//  - only the region covered by still-incomplete tiles is re-decoded (area
+//    decode, non-strict), and only after the available bytes grew by
+//    redecodeGrowth -- a trickle of small ranges no longer costs a full
+//    decode each
+// Untiled streams only benefit from the last point; tiled streams (and
+// tile-part per layer/resolution encodings) from all of them.
+
+namespace openjp2_api {
+
+namespace {
+    enum TileState : OPJ_BYTE { TILE_PENDING, TILE_FINAL };
+
+    OPJ_UINT32 ceildivpow2(OPJ_UINT32 a, OPJ_UINT32 b) {
+        return (OPJ_UINT32)(((OPJ_UINT64)a + (1u << b) - 1) >> b);
+    }
+
+    struct Region { OPJ_UINT32 x0, y0, x1, y1; };
+
+    Region tile_region(CodestreamInfo const& info, OPJ_UINT32 tileno) {
+        OPJ_UINT32 tx = tileno % info.numTilesX, ty = tileno / info.numTilesX;
+        return Region{
+            std::max(info.tx0 + tx * info.tdx, info.x0),
+            std::max(info.ty0 + ty * info.tdy, info.y0),
+            std::min(info.tx0 + (tx + 1) * info.tdx, info.x1),
+            std::min(info.ty0 + (ty + 1) * info.tdy, info.y1),
+        };
+    }
+
+    // full-size (reduced resolution) image matching what opj_decode would return
+    opj_image_t* create_composite(CodestreamInfo const& info, OPJ_UINT32 reduce) {
+        std::vector<opj_image_cmptparm_t> cmpt(info.comps.size());
+        for (size_t c = 0; c < cmpt.size(); c++) {
+            auto const& ic = info.comps[c];
+            memset(&cmpt[c], 0, sizeof(cmpt[c]));
+            cmpt[c].dx = ic.dx;
+            cmpt[c].dy = ic.dy;
+            cmpt[c].x0 = ceildiv(info.x0, ic.dx);
+            cmpt[c].y0 = ceildiv(info.y0, ic.dy);
+            cmpt[c].w = ceildivpow2(ceildiv(info.x1, ic.dx), reduce) - ceildivpow2(cmpt[c].x0, reduce);
+            cmpt[c].h = ceildivpow2(ceildiv(info.y1, ic.dy), reduce) - ceildivpow2(cmpt[c].y0, reduce);
+            cmpt[c].prec = ic.prec;
+            cmpt[c].sgnd = ic.sgnd;
+        }
+        opj_image_t* image = opj_image_create((OPJ_UINT32)cmpt.size(), cmpt.data(), OPJ_CLRSPC_UNSPECIFIED);
+        if (!image) return nullptr;
+        image->x0 = info.x0;
+        image->y0 = info.y0;
+        image->x1 = info.x1;
+        image->y1 = info.y1;
+        for (OPJ_UINT32 c = 0; c < image->numcomps; c++) image->comps[c].factor = reduce;
+        return image;
+    }
+
+    // copies the samples of src that fall inside region (reference grid) into dst.
+    // component x0/y0 are full-resolution, w/h are at the decoded resolution
+    // (see opj_j2k_update_image_dimensions)
+    void blit_region(opj_image_t* dst, opj_image_t const* src, Region const& region) {
+        dst->color_space = src->color_space;
+        for (OPJ_UINT32 c = 0; c < std::min(dst->numcomps, src->numcomps); c++) {
+            opj_image_comp_t& d = dst->comps[c];
+            opj_image_comp_t const& s = src->comps[c];
+            if (!s.data || !d.data) continue;
+            OPJ_UINT32 f = d.factor;
+            OPJ_UINT32 rx0 = ceildivpow2(ceildiv(region.x0, d.dx), f), rx1 = ceildivpow2(ceildiv(region.x1, d.dx), f);
+            OPJ_UINT32 ry0 = ceildivpow2(ceildiv(region.y0, d.dy), f), ry1 = ceildivpow2(ceildiv(region.y1, d.dy), f);
+            OPJ_UINT32 sx0 = ceildivpow2(s.x0, f), sy0 = ceildivpow2(s.y0, f);
+            OPJ_UINT32 dx0 = ceildivpow2(d.x0, f), dy0 = ceildivpow2(d.y0, f);
+            OPJ_UINT32 x0 = std::max({ rx0, sx0, dx0 }), x1 = std::min({ rx1, sx0 + s.w, dx0 + d.w });
+            OPJ_UINT32 y0 = std::max({ ry0, sy0, dy0 }), y1 = std::min({ ry1, sy0 + s.h, dy0 + d.h });
+            if (x0 >= x1 || y0 >= y1) continue;
+            for (OPJ_UINT32 y = y0; y < y1; y++) {
+                memcpy(d.data + (OPJ_SIZE_T)(y - dy0) * d.w + (x0 - dx0),
+                       s.data + (OPJ_SIZE_T)(y - sy0) * s.w + (x0 - sx0),
+                       sizeof(OPJ_INT32) * (x1 - x0));
+            }
+        }
+    }
+} // namespace
+
+struct ProgressiveDecoder {
+    ProgressiveOptions mOptions;
+    DecoderContext* mCtx = nullptr;
+    std::vector<OPJ_BYTE> mBytes;
+
+    CodestreamInfo mInfo;
+    OPJ_SIZE_T mScanOffset = 0;
+    bool mEoc = false;
+    std::vector<TilePart> mNewParts;
+    std::vector<OPJ_BYTE> mTileState;
+    std::vector<OPJ_UINT32> mPartsSeen;
+    std::vector<OPJ_UINT32> mPartsTotal;   // 0 until a tile-part signals TNsot
+
+    opj_image_t* mComposite = nullptr;
+    OPJ_SIZE_T mLastPartialBytes = 0;
+    ProgressiveStatus mStatus;
+
+    ~ProgressiveDecoder() {
+        if (mComposite) opj_image_destroy(mComposite);
+    }
+
+    bool streamComplete() const {
+        return mEoc || (mOptions.expectedSize && mBytes.size() >= mOptions.expectedSize);
+    }
+
+    bool parseHeader();
+    void scan();
+    bool decodeTile(OPJ_UINT32 tileno);
+    bool decodePartial();
+};
+
+bool ProgressiveDecoder::parseHeader() {
+    if (!parseCodestreamHeader(mBytes.data(), mBytes.size(), mInfo) || !mInfo.headerComplete) return false;
+    if (mInfo.numresolutions) {
+        mOptions.params.reduce = std::min(mOptions.params.reduce, mInfo.numresolutions - 1);
+    }
+    mComposite = create_composite(mInfo, mOptions.params.reduce);
+    if (!mComposite) return false;
+    OPJ_UINT32 tiles = mInfo.numTilesX * mInfo.numTilesY;
+    mTileState.assign(tiles, TILE_PENDING);
+    mPartsSeen.assign(tiles, 0);
+    mPartsTotal.assign(tiles, 0);
+    mScanOffset = mInfo.headerSize;
+    mStatus.headerParsed = true;
+    mStatus.tiles = tiles;
+    return true;
+}
+
+void ProgressiveDecoder::scan() {
+    bool eoc = false;
+    mNewParts.clear();
+    mScanOffset = scanTileParts(mBytes.data(), mBytes.size(), mScanOffset, mNewParts, &eoc);
+    mEoc = mEoc || eoc;
+    for (TilePart const& tp : mNewParts) {
+        if (tp.tileIndex >= mTileState.size()) continue;
+        mPartsSeen[tp.tileIndex]++;
+        if (tp.numParts) mPartsTotal[tp.tileIndex] = tp.numParts;
+    }
+}
+
+bool ProgressiveDecoder::decodeTile(OPJ_UINT32 tileno) {
+    mStatus.tileDecodes++;
+    opj_image_t* tile = mCtx->run(mBytes.data(), mBytes.size(), mOptions.params,
+        [tileno](opj_codec_t* codec, opj_stream_t* stream, opj_image_t* image) {
+            return opj_get_decoded_tile(codec, stream, image, tileno) != OPJ_FALSE;
+        });
+    if (!tile) return false;
+    blit_region(mComposite, tile, tile_region(mInfo, tileno));
+    opj_image_destroy(tile);
+    return true;
+}
+
+bool ProgressiveDecoder::decodePartial() {
+    Region area{ mInfo.x1, mInfo.y1, mInfo.x0, mInfo.y0 };
+    for (OPJ_UINT32 t = 0; t < mTileState.size(); t++) {
+        if (mTileState[t] == TILE_FINAL) continue;
+        Region r = tile_region(mInfo, t);
+        area = Region{ std::min(area.x0, r.x0), std::min(area.y0, r.y0), std::max(area.x1, r.x1), std::max(area.y1, r.y1) };
+    }
+    if (area.x0 >= area.x1 || area.y0 >= area.y1) return false;
+
+    DecodeParams params = mOptions.params;
+    params.strict = false; // the tail is truncated by definition
+    mStatus.partialDecodes++;
+    opj_image_t* partial = mCtx->run(mBytes.data(), mBytes.size(), params,
+        [area](opj_codec_t* codec, opj_stream_t* stream, opj_image_t* image) {
+            return opj_set_decode_area(codec, image, (OPJ_INT32)area.x0, (OPJ_INT32)area.y0, (OPJ_INT32)area.x1, (OPJ_INT32)area.y1)
+                && opj_decode(codec, stream, image);
+        });
+    if (!partial) return false;
+    // tiles finalized earlier keep their pixels; only pending ones are refreshed
+    for (OPJ_UINT32 t = 0; t < mTileState.size(); t++) {
+        if (mTileState[t] != TILE_FINAL) blit_region(mComposite, partial, tile_region(mInfo, t));
+    }
+    opj_image_destroy(partial);
+    return true;
+}
+
+ProgressiveDecoder* createProgressiveDecoder(ProgressiveOptions const& options, DecoderContext* ctx) {
+    auto dec = std::make_unique<ProgressiveDecoder>();
+    dec->mOptions = options;
+    dec->mCtx = ctx ? ctx : threadDecoderContext();
+    if (!dec->mCtx) return nullptr;
+    if (options.expectedSize) dec->mBytes.reserve(options.expectedSize);
+    return dec.release();
+}
+
+void destroyProgressiveDecoder(ProgressiveDecoder* dec) {
+    delete dec;
+}
+
+void appendBytes(ProgressiveDecoder* dec, const OPJ_BYTE* data, OPJ_SIZE_T size) {
+    if (!dec || !data || !size) return;
+    dec->mBytes.insert(dec->mBytes.end(), data, data + size);
+    dec->mStatus.bytes = dec->mBytes.size();
+}
+
+const opj_image_t* decodeAvailable(ProgressiveDecoder* dec, bool* updated) {
+    if (updated) *updated = false;
+    if (!dec) return nullptr;
+    if (!dec->mStatus.headerParsed && !dec->parseHeader()) return nullptr;
+
+    dec->scan();
+    bool complete = dec->streamComplete();
+    bool changed = false;
+
+    for (OPJ_UINT32 t = 0; t < dec->mTileState.size(); t++) {
+        if (dec->mTileState[t] == TILE_FINAL) continue;
+        bool allParts = dec->mPartsTotal[t] && dec->mPartsSeen[t] >= dec->mPartsTotal[t];
+        if (!allParts && !complete) continue;
+        // even on failure this is as good as the tile is going to get
+        changed = dec->decodeTile(t) || changed;
+        dec->mTileState[t] = TILE_FINAL;
+        dec->mStatus.tilesFinal++;
+    }
+
+    bool pending = dec->mStatus.tilesFinal < dec->mStatus.tiles;
+    OPJ_SIZE_T bytes = dec->mBytes.size();
+    if (pending && bytes > dec->mInfo.headerSize
+        && (!dec->mLastPartialBytes || bytes >= dec->mLastPartialBytes * dec->mOptions.redecodeGrowth)) {
+        changed = dec->decodePartial() || changed;
+        dec->mLastPartialBytes = bytes;
+    }
+
+    if (!changed) dec->mStatus.skippedUpdates++;
+    dec->mStatus.complete = !pending;
+    if (updated) *updated = changed;
+    return dec->mComposite;
+}
+
+ProgressiveStatus const& progressStatus(ProgressiveDecoder const* dec) {
+    return dec->mStatus;
+}
+
+CodestreamInfo const& codestreamInfo(ProgressiveDecoder const* dec) {
+    return dec->mInfo;
+}
+
+} // namespace openjp2_api
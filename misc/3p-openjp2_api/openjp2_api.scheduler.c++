@@ -0,0 +1,342 @@
+// openjp2_api batch decode scheduler
+// copyright (c) 2026 humbletim
+//
+// Teleporting into a busy region queues hundreds of texture decodes at once.
+// This is a small fixed pool built on DecoderContext: every worker owns a
+// priority queue (so submitters and workers rarely contend on one lock) and
+// steals from its peers when it runs dry. Jobs can be cancelled, downgraded
+// or re-prioritized while queued; rather than searching heaps, the job's
+// generation is bumped and it is re-queued -- stale heap entries are simply
+// skipped when popped.
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+namespace openjp2_api {
+
+struct DecodeJob {
+    enum State { QUEUED, RUNNING, RETIRED };
+    DecodeJobId id = 0;
+    DecodeRequest request;
+    std::chrono::steady_clock::time_point submitted;
+    std::mutex mutex;           // guards state, generation and request params/importance
+    State state = QUEUED;
+    OPJ_UINT32 generation = 0;  // queue entries with an older generation are stale
+};
+
+struct SchedulerQueue {
+    struct Entry {
+        float importance = 0.f;
+        OPJ_UINT32 reduce = 0;
+        OPJ_UINT64 seq = 0;
+        OPJ_UINT32 generation = 0;
+        std::shared_ptr<DecodeJob> job;
+
+        // max-heap ordering: "less" means "runs later"
+        bool operator<(Entry const& o) const {
+            if (importance != o.importance) return importance < o.importance;
+            if (reduce != o.reduce) return reduce < o.reduce;
+            return seq > o.seq;
+        }
+    };
+
+    std::mutex mutex;
+    std::vector<Entry> heap;
+
+    void push(Entry&& entry) {
+        std::lock_guard<std::mutex> lock(mutex);
+        heap.push_back(std::move(entry));
+        std::push_heap(heap.begin(), heap.end());
+    }
+
+    bool pop(Entry& out) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (heap.empty()) return false;
+        std::pop_heap(heap.begin(), heap.end());
+        out = std::move(heap.back());
+        heap.pop_back();
+        return true;
+    }
+};
+
+struct DecodeScheduler {
+    using steady = std::chrono::steady_clock;
+
+    std::vector<std::unique_ptr<SchedulerQueue>> mQueues;
+    std::vector<std::thread> mWorkers;
+    std::atomic<OPJ_UINT64> mNextId{ 1 };
+    std::atomic<OPJ_UINT64> mNextSeq{ 0 };
+    std::atomic<size_t> mRoundRobin{ 0 };
+
+    std::mutex mWakeMutex;           // guards the three members below
+    std::condition_variable mWake;
+    std::condition_variable mIdle;
+    size_t mEntries = 0;             // queue entries, including stale ones
+    size_t mOutstanding = 0;         // submitted and not yet retired
+    bool mStopping = false;
+
+    std::mutex mJobsMutex;
+    std::unordered_map<DecodeJobId, std::shared_ptr<DecodeJob>> mJobs;
+
+    mutable std::mutex mStatsMutex;
+    SchedulerStats mStats;
+    steady::time_point mFirstSubmit;
+    bool mStarted = false;
+
+    void enqueue(std::shared_ptr<DecodeJob> const& job);
+    std::shared_ptr<DecodeJob> find(DecodeJobId id);
+    bool take(size_t index, SchedulerQueue::Entry& out, bool& stolen);
+    void retire(std::shared_ptr<DecodeJob> const& job, DecodeResult&& result, bool stolen);
+    void workerLoop(size_t index);
+};
+
+void DecodeScheduler::enqueue(std::shared_ptr<DecodeJob> const& job) {
+    SchedulerQueue::Entry entry;
+    {
+        std::lock_guard<std::mutex> lock(job->mutex);
+        entry.importance = job->request.importance;
+        entry.reduce = job->request.params.reduce;
+        entry.generation = job->generation;
+    }
+    entry.seq = mNextSeq++;
+    entry.job = job;
+    // count before pushing: a worker can take the entry the moment it is
+    // queued, and its decrement must not run ahead of this increment
+    {
+        std::lock_guard<std::mutex> lock(mWakeMutex);
+        mEntries++;
+    }
+    mQueues[mRoundRobin++ % mQueues.size()]->push(std::move(entry));
+    mWake.notify_one();
+}
+
+std::shared_ptr<DecodeJob> DecodeScheduler::find(DecodeJobId id) {
+    std::lock_guard<std::mutex> lock(mJobsMutex);
+    auto it = mJobs.find(id);
+    return it == mJobs.end() ? nullptr : it->second;
+}
+
+bool DecodeScheduler::take(size_t index, SchedulerQueue::Entry& out, bool& stolen) {
+    stolen = false;
+    if (mQueues[index]->pop(out)) return true;
+    for (size_t i = 1; i < mQueues.size(); i++) {
+        if (mQueues[(index + i) % mQueues.size()]->pop(out)) {
+            stolen = true;
+            return true;
+        }
+    }
+    return false;
+}
+
+void DecodeScheduler::retire(std::shared_ptr<DecodeJob> const& job, DecodeResult&& result, bool stolen) {
+    std::function<void(DecodeResult&&)> callback;
+    {
+        std::lock_guard<std::mutex> lock(job->mutex);
+        callback = std::move(job->request.onComplete);
+        job->request.keepAlive.reset(); // stale queue entries may keep the job itself around a little longer
+    }
+    {
+        std::lock_guard<std::mutex> lock(mJobsMutex);
+        mJobs.erase(job->id);
+    }
+    {
+        std::lock_guard<std::mutex> lock(mStatsMutex);
+        switch (result.status) {
+        case DecodeResult::DONE:
+            mStats.completed++;
+            if (result.image && result.image->numcomps) mStats.pixels += (OPJ_UINT64)result.image->comps[0].w * result.image->comps[0].h;
+            break;
+        case DecodeResult::FAILED: mStats.failed++; break;
+        case DecodeResult::CANCELLED: mStats.cancelled++; break;
+        }
+        if (result.status != DecodeResult::CANCELLED) {
+            mStats.queueSecondsTotal += result.queueSeconds;
+            mStats.queueSecondsMax = std::max(mStats.queueSecondsMax, result.queueSeconds);
+            mStats.decodeSecondsTotal += result.decodeSeconds;
+        }
+        if (stolen) mStats.stolen++;
+    }
+    if (callback) {
+        callback(std::move(result));
+    } else if (result.image) {
+        opj_image_destroy(result.image);
+    }
+    {
+        std::lock_guard<std::mutex> lock(mWakeMutex);
+        mOutstanding--;
+    }
+    mIdle.notify_all();
+}
+
+void DecodeScheduler::workerLoop(size_t index) {
+    DecoderContext* ctx = threadDecoderContext();
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mWakeMutex);
+            mWake.wait(lock, [this] { return mStopping || mEntries > 0; });
+            if (mStopping) return;
+        }
+        SchedulerQueue::Entry entry;
+        bool stolen = false;
+        if (!take(index, entry, stolen)) {
+            std::this_thread::yield(); // counted but not yet pushed (see enqueue)
+            continue;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mWakeMutex);
+            mEntries--;
+        }
+
+        DecodeJob& job = *entry.job;
+        DecodeParams params;
+        {
+            std::lock_guard<std::mutex> lock(job.mutex);
+            if (job.state != DecodeJob::QUEUED || job.generation != entry.generation) continue; // stale
+            job.state = DecodeJob::RUNNING;
+            params = job.request.params;
+        }
+
+        auto start = steady::now();
+        DecodeResult result;
+        result.id = job.id;
+        result.reduce = params.reduce;
+        result.queueSeconds = std::chrono::duration<double>(start - job.submitted).count();
+        result.image = ctx ? decode(ctx, job.request.data, job.request.size, params) : nullptr;
+        result.decodeSeconds = std::chrono::duration<double>(steady::now() - start).count();
+        result.status = result.image ? DecodeResult::DONE : DecodeResult::FAILED;
+        if (!result.image) result.error = ctx ? lastError(ctx) : "no decoder context";
+        {
+            std::lock_guard<std::mutex> lock(job.mutex);
+            job.state = DecodeJob::RETIRED;
+        }
+        retire(entry.job, std::move(result), stolen);
+    }
+}
+
+DecodeScheduler* createDecodeScheduler(int num_workers) {
+    if (num_workers <= 0) num_workers = (int)std::max(1u, std::thread::hardware_concurrency());
+    auto sched = std::make_unique<DecodeScheduler>();
+    for (int i = 0; i < num_workers; i++) sched->mQueues.push_back(std::make_unique<SchedulerQueue>());
+    for (int i = 0; i < num_workers; i++) {
+        DecodeScheduler* self = sched.get();
+        sched->mWorkers.emplace_back([self, i] { self->workerLoop((size_t)i); });
+    }
+    return sched.release();
+}
+
+void destroyDecodeScheduler(DecodeScheduler* sched) {
+    if (!sched) return;
+    {
+        std::lock_guard<std::mutex> lock(sched->mWakeMutex);
+        sched->mStopping = true;
+    }
+    sched->mWake.notify_all();
+    for (std::thread& worker : sched->mWorkers) worker.join();
+
+    std::vector<DecodeJobId> remaining;
+    {
+        std::lock_guard<std::mutex> lock(sched->mJobsMutex);
+        for (auto const& it : sched->mJobs) remaining.push_back(it.first);
+    }
+    for (DecodeJobId id : remaining) cancel(sched, id);
+    delete sched;
+}
+
+DecodeJobId submit(DecodeScheduler* sched, DecodeRequest request) {
+    if (!sched || !request.data || !request.size) return 0;
+    auto job = std::make_shared<DecodeJob>();
+    job->id = sched->mNextId++;
+    job->request = std::move(request);
+    job->submitted = DecodeScheduler::steady::now();
+    {
+        std::lock_guard<std::mutex> lock(sched->mStatsMutex);
+        if (!sched->mStarted) {
+            sched->mStarted = true;
+            sched->mFirstSubmit = job->submitted;
+        }
+        sched->mStats.submitted++;
+    }
+    {
+        std::lock_guard<std::mutex> lock(sched->mJobsMutex);
+        sched->mJobs[job->id] = job;
+    }
+    {
+        std::lock_guard<std::mutex> lock(sched->mWakeMutex);
+        sched->mOutstanding++;
+    }
+    sched->enqueue(job);
+    return job->id;
+}
+
+bool cancel(DecodeScheduler* sched, DecodeJobId id) {
+    auto job = sched ? sched->find(id) : nullptr;
+    if (!job) return false;
+    {
+        std::lock_guard<std::mutex> lock(job->mutex);
+        if (job->state != DecodeJob::QUEUED) return false;
+        job->state = DecodeJob::RETIRED;
+    }
+    DecodeResult result;
+    result.id = id;
+    result.status = DecodeResult::CANCELLED;
+    result.reduce = job->request.params.reduce;
+    sched->retire(job, std::move(result), false);
+    return true;
+}
+
+bool downgrade(DecodeScheduler* sched, DecodeJobId id, OPJ_UINT32 reduce) {
+    auto job = sched ? sched->find(id) : nullptr;
+    if (!job) return false;
+    {
+        std::lock_guard<std::mutex> lock(job->mutex);
+        if (job->state != DecodeJob::QUEUED || reduce <= job->request.params.reduce) return false;
+        job->request.params.reduce = reduce;
+        job->generation++;
+    }
+    {
+        std::lock_guard<std::mutex> lock(sched->mStatsMutex);
+        sched->mStats.downgraded++;
+    }
+    sched->enqueue(job);
+    return true;
+}
+
+bool reprioritize(DecodeScheduler* sched, DecodeJobId id, float importance) {
+    auto job = sched ? sched->find(id) : nullptr;
+    if (!job) return false;
+    {
+        std::lock_guard<std::mutex> lock(job->mutex);
+        if (job->state != DecodeJob::QUEUED) return false;
+        if (job->request.importance == importance) return true;
+        job->request.importance = importance;
+        job->generation++;
+    }
+    sched->enqueue(job);
+    return true;
+}
+
+void waitIdle(DecodeScheduler* sched) {
+    if (!sched) return;
+    std::unique_lock<std::mutex> lock(sched->mWakeMutex);
+    sched->mIdle.wait(lock, [sched] { return sched->mOutstanding == 0; });
+}
+
+SchedulerStats stats(DecodeScheduler const* sched) {
+    std::lock_guard<std::mutex> lock(sched->mStatsMutex);
+    SchedulerStats snapshot = sched->mStats;
+    if (sched->mStarted) {
+        snapshot.wallSeconds = std::chrono::duration<double>(DecodeScheduler::steady::now() - sched->mFirstSubmit).count();
+    }
+    return snapshot;
+}
+
+void resetStats(DecodeScheduler* sched) {
+    std::lock_guard<std::mutex> lock(sched->mStatsMutex);
+    sched->mStats = SchedulerStats{};
+    sched->mStarted = false;
+}
+
+} // namespace openjp2_api
@@ -0,0 +1,275 @@
+// openjp2_api runtime-dispatched SIMD builds of dwt.c / mct.c
+// copyright (c) 2026 humbletim
+//
+// OpenJPEG already carries SSE2/SSSE3/AVX2 paths for the inverse wavelet and
+// colour transforms, but picks them at compile time (__SSE2__, __AVX2__...).
+// The viewer builds for a baseline target (and MSVC never defines those
+// macros), so the amalgamation effectively always ran the scalar code.
+//
+// Here the same upstream sources are compiled twice more inside their own
+// namespaces -- once with the SSE4.1 feature set and once with AVX2 -- using
+// per-function target attributes instead of global compiler flags, and the
+// four entry points tcd.c calls are routed through a table picked from CPUID.
+// The baseline build (see the renames around dwt.c/mct.c in openjp2_api.h;
+// SSE2 on x64, reported as SIMD_BASELINE) remains the fallback and the
+// reference for bit-exactness checks.
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+
+#if OPENJP2_API_SIMD_DISPATCH
+
+#ifdef _MSC_VER
+  #include <intrin.h>
+#endif
+// pulled in at global scope up front so the upstream #include <xmmintrin.h>
+// etc. below become no-ops instead of landing inside a namespace
+#include <immintrin.h>
+
+#if defined(__clang__)
+  #pragma clang diagnostic push
+  #pragma clang diagnostic ignored "-Wmacro-redefined"
+#elif defined(_MSC_VER)
+  #pragma warning(push)
+  #pragma warning(disable: 4005) // macro redefinition
+#endif
+
+#pragma push_macro("__SSE__")
+#pragma push_macro("__SSE2__")
+#pragma push_macro("__SSSE3__")
+#pragma push_macro("__SSE4_1__")
+#pragma push_macro("__AVX__")
+#pragma push_macro("__AVX2__")
+
+// helper macros dwt.c defines differently depending on the vector width
+#undef VREG
+#undef VREG_INT_COUNT
+#undef PARALLEL_COLS_53
+#undef LOAD_CST
+#undef LOAD
+#undef LOADU
+#undef STORE
+#undef STOREU
+#undef ADD
+#undef ADD3
+#undef SUB
+#undef SAR
+
+// --- SSE4.1 (plus the SSE2/SSSE3 paths it implies) ---
+#if defined(__clang__)
+  #pragma clang attribute push(__attribute__((target("sse4.1"))), apply_to = function)
+#elif defined(__GNUC__)
+  #pragma GCC push_options
+  #pragma GCC target("sse4.1")
+#endif
+#define __SSE__ 1
+#define __SSE2__ 1
+#define __SSSE3__ 1
+#define __SSE4_1__ 1
+namespace openjp2_api { namespace sse41 {
+#include "openjpeg/src/lib/openjp2/dwt.c"
+#include "openjpeg/src/lib/openjp2/mct.c"
+}} // namespace openjp2_api::sse41
+#if defined(__clang__)
+  #pragma clang attribute pop
+#elif defined(__GNUC__)
+  #pragma GCC pop_options
+#endif
+
+#undef VREG
+#undef VREG_INT_COUNT
+#undef PARALLEL_COLS_53
+#undef LOAD_CST
+#undef LOAD
+#undef LOADU
+#undef STORE
+#undef STOREU
+#undef ADD
+#undef ADD3
+#undef SUB
+#undef SAR
+
+// --- AVX2 ---
+#if defined(__clang__)
+  #pragma clang attribute push(__attribute__((target("avx2"))), apply_to = function)
+#elif defined(__GNUC__)
+  #pragma GCC push_options
+  #pragma GCC target("avx2")
+#endif
+#define __SSE__ 1
+#define __SSE2__ 1
+#define __SSSE3__ 1
+#define __SSE4_1__ 1
+#define __AVX__ 1
+#define __AVX2__ 1
+namespace openjp2_api { namespace avx2 {
+#include "openjpeg/src/lib/openjp2/dwt.c"
+#include "openjpeg/src/lib/openjp2/mct.c"
+}} // namespace openjp2_api::avx2
+#if defined(__clang__)
+  #pragma clang attribute pop
+#elif defined(__GNUC__)
+  #pragma GCC pop_options
+#endif
+
+#pragma pop_macro("__SSE__")
+#pragma pop_macro("__SSE2__")
+#pragma pop_macro("__SSSE3__")
+#pragma pop_macro("__SSE4_1__")
+#pragma pop_macro("__AVX__")
+#pragma pop_macro("__AVX2__")
+
+#if defined(__clang__)
+  #pragma clang diagnostic pop
+#elif defined(_MSC_VER)
+  #pragma warning(pop)
+#endif
+
+#endif // OPENJP2_API_SIMD_DISPATCH
+
+namespace openjp2_api { namespace simd {
+
+    struct Kernels {
+        OPJ_BOOL (*dwt_decode)(opj_tcd_t*, opj_tcd_tilecomp_t*, OPJ_UINT32);
+        OPJ_BOOL (*dwt_decode_real)(opj_tcd_t*, opj_tcd_tilecomp_t*, OPJ_UINT32);
+        void (*mct_decode)(OPJ_INT32*, OPJ_INT32*, OPJ_INT32*, OPJ_SIZE_T);
+        void (*mct_decode_real)(OPJ_FLOAT32*, OPJ_FLOAT32*, OPJ_FLOAT32*, OPJ_SIZE_T);
+    };
+
+#if OPENJP2_API_SIMD_DISPATCH
+    const Kernels KERNELS[] = {
+        { opj_dwt_decode_baseline, opj_dwt_decode_real_baseline, opj_mct_decode_baseline, opj_mct_decode_real_baseline },
+        { sse41::opj_dwt_decode, sse41::opj_dwt_decode_real, sse41::opj_mct_decode, sse41::opj_mct_decode_real },
+        { avx2::opj_dwt_decode, avx2::opj_dwt_decode_real, avx2::opj_mct_decode, avx2::opj_mct_decode_real },
+    };
+#endif
+
+    // per-kernel wall time, only collected while `profiling` is set (bench use)
+    struct KernelTimes {
+        std::atomic<OPJ_UINT64> nanos[4];
+        std::atomic<OPJ_UINT64> calls[4];
+    };
+    enum { KERNEL_DWT53, KERNEL_DWT97, KERNEL_RCT, KERNEL_ICT };
+    const char* const KERNEL_NAMES[] = { "idwt 5/3", "idwt 9/7", "inverse rct", "inverse ict" };
+
+    std::atomic<bool> profiling{ false };
+    KernelTimes times;
+    std::atomic<int> active_level{ -1 };
+
+    void reset_times() {
+        for (int k = 0; k < 4; k++) { times.nanos[k] = 0; times.calls[k] = 0; }
+    }
+
+    SimdLevel detect() {
+#if !OPENJP2_API_SIMD_DISPATCH
+        return SIMD_BASELINE;
+#elif defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 0);
+        int max_leaf = info[0];
+        __cpuid(info, 1);
+        bool sse41 = (info[2] & (1 << 19)) != 0;
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        bool avx = (info[2] & (1 << 28)) != 0;
+        bool avx2 = false;
+        if (max_leaf >= 7 && osxsave && avx && (_xgetbv(0) & 6) == 6) { // OS saves YMM state
+            __cpuidex(info, 7, 0);
+            avx2 = (info[1] & (1 << 5)) != 0;
+        }
+        return avx2 ? SIMD_AVX2 : sse41 ? SIMD_SSE41 : SIMD_BASELINE;
+#else
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) return SIMD_AVX2;
+        if (__builtin_cpu_supports("sse4.1")) return SIMD_SSE41;
+        return SIMD_BASELINE;
+#endif
+    }
+
+    SimdLevel default_level() {
+        SimdLevel level = detectedSimdLevel();
+        if (const char* env = getenv("OPENJP2_API_SIMD")) {
+            for (int l = SIMD_BASELINE; l <= SIMD_AVX2; l++) {
+                if (!strcmp(env, simdLevelName((SimdLevel)l))) level = std::min(level, (SimdLevel)l);
+            }
+        }
+        return level;
+    }
+
+    inline int level() {
+        int l = active_level.load(std::memory_order_relaxed);
+        if (l < 0) {
+            l = default_level();
+            active_level.store(l, std::memory_order_relaxed);
+        }
+        return l;
+    }
+
+    // times one kernel call when profiling, otherwise just forwards
+    template <typename F>
+    inline auto timed(int kernel, F&& call) -> decltype(call()) {
+        if (!profiling.load(std::memory_order_relaxed)) return call();
+        struct Scope {
+            int kernel;
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            ~Scope() {
+                times.nanos[kernel] += (OPJ_UINT64)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+                times.calls[kernel]++;
+            }
+        } scope{ kernel };
+        return call();
+    }
+
+}} // namespace openjp2_api::simd
+
+namespace openjp2_api {
+
+SimdLevel detectedSimdLevel() {
+    static const SimdLevel detected = simd::detect();
+    return detected;
+}
+
+SimdLevel simdLevel() {
+    return (SimdLevel)simd::level();
+}
+
+SimdLevel setSimdLevel(SimdLevel level) {
+    level = std::min(std::max(level, SIMD_BASELINE), detectedSimdLevel());
+    simd::active_level.store(level);
+    return level;
+}
+
+const char* simdLevelName(SimdLevel level) {
+    switch (level) {
+    case SIMD_BASELINE: return "baseline";
+    case SIMD_SSE41: return "sse41";
+    case SIMD_AVX2: return "avx2";
+    }
+    return "?";
+}
+
+} // namespace openjp2_api
+
+#if OPENJP2_API_SIMD_DISPATCH
+// the entry points tcd.c links against (declared in dwt.h / mct.h)
+OPJ_BOOL opj_dwt_decode(opj_tcd_t* p_tcd, opj_tcd_tilecomp_t* tilec, OPJ_UINT32 numres) {
+    using namespace openjp2_api::simd;
+    return timed(KERNEL_DWT53, [&] { return KERNELS[level()].dwt_decode(p_tcd, tilec, numres); });
+}
+
+OPJ_BOOL opj_dwt_decode_real(opj_tcd_t* p_tcd, opj_tcd_tilecomp_t* tilec, OPJ_UINT32 numres) {
+    using namespace openjp2_api::simd;
+    return timed(KERNEL_DWT97, [&] { return KERNELS[level()].dwt_decode_real(p_tcd, tilec, numres); });
+}
+
+void opj_mct_decode(OPJ_INT32* c0, OPJ_INT32* c1, OPJ_INT32* c2, OPJ_SIZE_T n) {
+    using namespace openjp2_api::simd;
+    timed(KERNEL_RCT, [&] { KERNELS[level()].mct_decode(c0, c1, c2, n); });
+}
+
+void opj_mct_decode_real(OPJ_FLOAT32* c0, OPJ_FLOAT32* c1, OPJ_FLOAT32* c2, OPJ_SIZE_T n) {
+    using namespace openjp2_api::simd;
+    timed(KERNEL_ICT, [&] { KERNELS[level()].mct_decode_real(c0, c1, c2, n); });
+}
+#endif // OPENJP2_API_SIMD_DISPATCH
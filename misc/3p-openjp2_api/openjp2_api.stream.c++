@@ -0,0 +1,205 @@
+// openjp2_api span-backed input streams (memory buffers and mapped files)
+// copyright (c) 2026 humbletim
+//
+// A regular opj_stream_t copies twice: the read callback fills the stream's
+// internal buffer, then opj_stream_read_data copies out of it into the
+// codec's own buffers. When the whole codestream is already addressable
+// (a buffer we were handed, or a mapped cache file) the internal buffer can
+// simply *be* that memory: it is presented as one fully-buffered read that
+// has already hit end-of-stream, and skip/seek just move the cursor. That
+// drops the first copy and the 64K staging buffer altogether.
+//
+// The stream's own (tiny) buffer is swapped back in before opj_stream_destroy
+// frees it. Input streams never write through m_stored_data, so pointing it
+// at read-only memory is safe.
+
+#ifdef _WIN32
+  // (already pulled in by thread.c for MUTEX_win32)
+  #include <windows.h>
+#else
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+namespace openjp2_api {
+
+struct MappedFile {
+    const OPJ_BYTE* data = nullptr;
+    OPJ_SIZE_T size = 0;
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+#endif
+};
+
+// user data of a span-backed stream
+struct SpanSource {
+    const OPJ_BYTE* data = nullptr;
+    OPJ_SIZE_T size = 0;
+    OPJ_BYTE* ownBuffer = nullptr;   // the stream's allocation, restored before destroy
+    MappedFile* mapping = nullptr;   // owned when the stream was made by createMappedFileStream
+    opj_stream_private_t* stream = nullptr;
+};
+
+namespace {
+    opj_stream_private_t* stream_private(opj_stream_t* stream) {
+        return reinterpret_cast<opj_stream_private_t*>(stream);
+    }
+
+    void span_reposition(opj_stream_private_t* s, SpanSource const* src, OPJ_SIZE_T offset) {
+        offset = std::min(offset, src->size);
+        s->m_current_data = const_cast<OPJ_BYTE*>(src->data) + offset;
+        s->m_bytes_in_buffer = src->size - offset;
+        s->m_byte_offset = (OPJ_OFF_T)offset;
+        s->m_status = OPJ_STREAM_STATUS_INPUT | OPJ_STREAM_STATUS_END;
+    }
+
+    OPJ_OFF_T span_skip(opj_stream_private_t* s, OPJ_OFF_T nb_bytes, opj_event_mgr_t*) {
+        auto* src = static_cast<SpanSource*>(s->m_user_data);
+        OPJ_OFF_T target = std::max<OPJ_OFF_T>(0, std::min<OPJ_OFF_T>(s->m_byte_offset + nb_bytes, (OPJ_OFF_T)src->size));
+        OPJ_OFF_T moved = target - s->m_byte_offset;
+        span_reposition(s, src, (OPJ_SIZE_T)target);
+        return moved;
+    }
+
+    OPJ_BOOL span_seek(opj_stream_private_t* s, OPJ_OFF_T offset, opj_event_mgr_t*) {
+        auto* src = static_cast<SpanSource*>(s->m_user_data);
+        if (offset < 0 || (OPJ_SIZE_T)offset > src->size) {
+            s->m_status |= OPJ_STREAM_STATUS_ERROR;
+            return OPJ_FALSE;
+        }
+        span_reposition(s, src, (OPJ_SIZE_T)offset);
+        return OPJ_TRUE;
+    }
+
+    // never called (everything is "buffered" up front); installed so the
+    // stream reports itself seekable (opj_stream_has_seek)
+    OPJ_SIZE_T span_read_fn(void*, OPJ_SIZE_T, void*) { return (OPJ_SIZE_T)-1; }
+    OPJ_OFF_T span_skip_fn(OPJ_OFF_T, void*) { return -1; }
+    OPJ_BOOL span_seek_fn(OPJ_OFF_T, void*) { return OPJ_FALSE; }
+
+    // turns a freshly created input stream into a span stream over src
+    void span_install(opj_stream_t* stream, SpanSource* src) {
+        opj_stream_set_read_function(stream, span_read_fn);
+        opj_stream_set_skip_function(stream, span_skip_fn);
+        opj_stream_set_seek_function(stream, span_seek_fn);
+        opj_stream_private_t* s = stream_private(stream);
+        src->stream = s;
+        src->ownBuffer = s->m_stored_data;
+        s->m_user_data = src;
+        s->m_opj_skip = span_skip;
+        s->m_opj_seek = span_seek;
+    }
+
+    // (re)points an installed span stream at new memory
+    void span_attach(SpanSource* src, const OPJ_BYTE* data, OPJ_SIZE_T size) {
+        src->data = data;
+        src->size = size;
+        src->stream->m_stored_data = const_cast<OPJ_BYTE*>(data);
+        src->stream->m_user_data_length = size;
+        span_reposition(src->stream, src, 0);
+    }
+
+    // hands the stream its own buffer back so opj_stream_destroy frees the right thing
+    void span_release(SpanSource* src) {
+        if (src->stream) src->stream->m_stored_data = src->ownBuffer;
+        if (src->mapping) unmapFile(src->mapping);
+    }
+
+    void span_free_user_data(void* user_data) {
+        auto* src = static_cast<SpanSource*>(user_data);
+        span_release(src);
+        delete src;
+    }
+} // namespace
+
+opj_stream_t* createSpanStream(const OPJ_BYTE* data, OPJ_SIZE_T size) {
+    if (!data || !size) return nullptr;
+    opj_stream_t* stream = opj_stream_create(1, OPJ_TRUE); // the buffer is replaced by the span
+    if (!stream) return nullptr;
+    auto* src = new SpanSource;
+    span_install(stream, src);
+    opj_stream_set_user_data(stream, src, span_free_user_data);
+    span_attach(src, data, size);
+    return stream;
+}
+
+opj_stream_t* createMappedFileStream(const char* path) {
+    MappedFile* file = mapFile(path);
+    if (!file) return nullptr;
+    opj_stream_t* stream = createSpanStream(file->data, file->size);
+    if (!stream) {
+        unmapFile(file);
+        return nullptr;
+    }
+    static_cast<SpanSource*>(stream_private(stream)->m_user_data)->mapping = file;
+    return stream;
+}
+
+MappedFile* mapFile(const char* path) {
+    if (!path) return nullptr;
+    auto file = std::make_unique<MappedFile>();
+#ifdef _WIN32
+    int wlen = MultiByteToWideChar(CP_UTF8, 0, path, -1, nullptr, 0);
+    if (wlen <= 0) return nullptr;
+    std::wstring wpath((size_t)wlen, L'\0');
+    MultiByteToWideChar(CP_UTF8, 0, path, -1, &wpath[0], wlen);
+    file->file = CreateFileW(wpath.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file->file == INVALID_HANDLE_VALUE) return nullptr;
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file->file, &size) || size.QuadPart <= 0) {
+        CloseHandle(file->file);
+        return nullptr;
+    }
+    file->mapping = CreateFileMappingW(file->file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!file->mapping) {
+        CloseHandle(file->file);
+        return nullptr;
+    }
+    file->data = static_cast<const OPJ_BYTE*>(MapViewOfFile(file->mapping, FILE_MAP_READ, 0, 0, 0));
+    if (!file->data) {
+        CloseHandle(file->mapping);
+        CloseHandle(file->file);
+        return nullptr;
+    }
+    file->size = (OPJ_SIZE_T)size.QuadPart;
+#else
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return nullptr;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        close(fd);
+        return nullptr;
+    }
+    void* addr = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // the mapping keeps the file referenced
+    if (addr == MAP_FAILED) return nullptr;
+    file->data = static_cast<const OPJ_BYTE*>(addr);
+    file->size = (OPJ_SIZE_T)st.st_size;
+#endif
+    return file.release();
+}
+
+void unmapFile(MappedFile* file) {
+    if (!file) return;
+#ifdef _WIN32
+    if (file->data) UnmapViewOfFile(file->data);
+    if (file->mapping) CloseHandle(file->mapping);
+    if (file->file != INVALID_HANDLE_VALUE) CloseHandle(file->file);
+#else
+    if (file->data) munmap(const_cast<OPJ_BYTE*>(file->data), file->size);
+#endif
+    delete file;
+}
+
+const OPJ_BYTE* mappedData(MappedFile const* file) {
+    return file ? file->data : nullptr;
+}
+
+OPJ_SIZE_T mappedSize(MappedFile const* file) {
+    return file ? file->size : 0;
+}
+
+} // namespace openjp2_api
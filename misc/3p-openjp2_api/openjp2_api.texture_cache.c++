@@ -0,0 +1,406 @@
+// openjp2_api persistent cache of decoded textures
+// copyright (c) 2026 humbletim
+//
+// Texture assets are immutable per UUID, yet every login and every region
+// revisit decodes the same codestreams at the same discard levels again.
+// This keeps the decoder's output on disk instead: one file per
+// (uuid, discard level) holding the component layout plus the raw samples,
+// narrowed to 1/2/4 bytes by precision (8-bit textures take a quarter of
+// opj_image_t's OPJ_INT32 planes). A hit maps the file and widens the
+// samples straight into a fresh opj_image_t -- no T1/T2, no wavelet.
+//
+// The directory is bounded by size with LRU eviction. Recency survives
+// restarts through the files' modification times (bumped on each hit).
+// Entries are written to a temporary file and renamed into place, so a
+// crash never leaves a half-written entry behind under its real name.
+
+#include <cctype>
+#include <filesystem>
+#include <fstream>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+namespace openjp2_api {
+
+namespace {
+    namespace fs = std::filesystem;
+
+    constexpr char CACHE_MAGIC[4] = { 'O', 'J', 'T', 'C' };
+    constexpr OPJ_UINT32 CACHE_VERSION = 1;
+    constexpr const char* CACHE_EXTENSION = ".ojtc";
+
+    // native byte order -- cache files never leave the machine that wrote them
+    struct CacheFileHeader {
+        char magic[4];
+        OPJ_UINT32 version;
+        OPJ_UINT64 sourceSize;   // codestream bytes the entry was decoded from (0 == unknown)
+        OPJ_UINT32 discard;
+        OPJ_UINT32 x0, y0, x1, y1;
+        OPJ_INT32 colorSpace;
+        OPJ_UINT32 numcomps;
+        OPJ_UINT32 reserved;
+    };
+
+    struct CacheFileComponent {
+        OPJ_UINT32 dx, dy, w, h, x0, y0;
+        OPJ_UINT32 prec, sgnd, factor, alpha;
+        OPJ_UINT32 bytesPerSample;   // 1, 2 or 4
+        OPJ_UINT32 reserved;
+    };
+
+    OPJ_UINT32 bytes_per_sample(OPJ_UINT32 prec) {
+        return prec <= 8 ? 1 : prec <= 16 ? 2 : 4;
+    }
+
+    // asset ids are UUIDs; anything else could escape the cache directory
+    bool valid_uuid(std::string const& uuid) {
+        if (uuid.empty() || uuid.size() > 64) return false;
+        for (char ch : uuid) {
+            if (!isalnum((unsigned char)ch) && ch != '-') return false;
+        }
+        return true;
+    }
+
+    std::string entry_key(std::string const& uuid, OPJ_UINT32 discard) {
+        std::string key = uuid;
+        for (char& ch : key) ch = (char)tolower((unsigned char)ch);
+        return key + "_" + std::to_string(discard);
+    }
+
+    template <typename T>
+    void widen_samples(OPJ_INT32* dst, const OPJ_BYTE* src, OPJ_SIZE_T count) {
+        if (sizeof(T) == sizeof(OPJ_INT32)) {
+            memcpy(dst, src, count * sizeof(T));
+            return;
+        }
+        for (OPJ_SIZE_T i = 0; i < count; i++) {
+            T value;
+            memcpy(&value, src + i * sizeof(T), sizeof(T));
+            dst[i] = (OPJ_INT32)value;
+        }
+    }
+
+    template <typename T>
+    void narrow_samples(std::vector<OPJ_BYTE>& out, const OPJ_INT32* src, OPJ_SIZE_T count) {
+        OPJ_SIZE_T at = out.size();
+        out.resize(at + count * sizeof(T));
+        for (OPJ_SIZE_T i = 0; i < count; i++) {
+            T value = (T)src[i];
+            memcpy(out.data() + at + i * sizeof(T), &value, sizeof(T));
+        }
+    }
+
+    // serialized entry; empty if the image cannot be represented
+    std::vector<OPJ_BYTE> serialize_image(opj_image_t const* image, OPJ_UINT32 discard, OPJ_UINT64 sourceSize) {
+        std::vector<OPJ_BYTE> out;
+        if (!image || !image->numcomps) return out;
+        CacheFileHeader header{};
+        memcpy(header.magic, CACHE_MAGIC, sizeof(header.magic));
+        header.version = CACHE_VERSION;
+        header.sourceSize = sourceSize;
+        header.discard = discard;
+        header.x0 = image->x0;
+        header.y0 = image->y0;
+        header.x1 = image->x1;
+        header.y1 = image->y1;
+        header.colorSpace = (OPJ_INT32)image->color_space;
+        header.numcomps = image->numcomps;
+
+        std::vector<CacheFileComponent> comps(image->numcomps);
+        OPJ_SIZE_T samples_bytes = 0;
+        for (OPJ_UINT32 c = 0; c < image->numcomps; c++) {
+            opj_image_comp_t const& ic = image->comps[c];
+            if (!ic.data) return out;
+            comps[c] = CacheFileComponent{ ic.dx, ic.dy, ic.w, ic.h, ic.x0, ic.y0, ic.prec, ic.sgnd, ic.factor, ic.alpha, bytes_per_sample(ic.prec), 0 };
+            samples_bytes += (OPJ_SIZE_T)ic.w * ic.h * comps[c].bytesPerSample;
+        }
+
+        out.reserve(sizeof(header) + sizeof(CacheFileComponent) * comps.size() + samples_bytes);
+        out.insert(out.end(), (const OPJ_BYTE*)&header, (const OPJ_BYTE*)(&header + 1));
+        out.insert(out.end(), (const OPJ_BYTE*)comps.data(), (const OPJ_BYTE*)(comps.data() + comps.size()));
+        for (OPJ_UINT32 c = 0; c < image->numcomps; c++) {
+            opj_image_comp_t const& ic = image->comps[c];
+            OPJ_SIZE_T count = (OPJ_SIZE_T)ic.w * ic.h;
+            switch (comps[c].bytesPerSample) {
+            case 1: ic.sgnd ? narrow_samples<OPJ_INT8>(out, ic.data, count) : narrow_samples<OPJ_BYTE>(out, ic.data, count); break;
+            case 2: ic.sgnd ? narrow_samples<OPJ_INT16>(out, ic.data, count) : narrow_samples<OPJ_UINT16>(out, ic.data, count); break;
+            default: narrow_samples<OPJ_INT32>(out, ic.data, count); break;
+            }
+        }
+        return out;
+    }
+
+    // rebuilds the image from a mapped entry; nullptr if it is truncated,
+    // from another version or does not match the request
+    opj_image_t* deserialize_image(const OPJ_BYTE* data, OPJ_SIZE_T size, OPJ_UINT32 discard, OPJ_UINT64 sourceSize) {
+        CacheFileHeader header;
+        if (size < sizeof(header)) return nullptr;
+        memcpy(&header, data, sizeof(header));
+        if (memcmp(header.magic, CACHE_MAGIC, sizeof(header.magic)) || header.version != CACHE_VERSION) return nullptr;
+        if (header.discard != discard || (sourceSize && header.sourceSize && header.sourceSize != sourceSize)) return nullptr;
+        if (!header.numcomps || header.numcomps > 16384) return nullptr;
+
+        OPJ_SIZE_T offset = sizeof(header);
+        if (size - offset < sizeof(CacheFileComponent) * (OPJ_SIZE_T)header.numcomps) return nullptr;
+        std::vector<CacheFileComponent> comps(header.numcomps);
+        memcpy(comps.data(), data + offset, sizeof(CacheFileComponent) * comps.size());
+        offset += sizeof(CacheFileComponent) * comps.size();
+
+        std::vector<opj_image_cmptparm_t> cmpt(comps.size());
+        OPJ_UINT64 samples_bytes = 0;
+        for (size_t c = 0; c < comps.size(); c++) {
+            CacheFileComponent const& fc = comps[c];
+            if (fc.bytesPerSample != bytes_per_sample(fc.prec)) return nullptr;
+            memset(&cmpt[c], 0, sizeof(cmpt[c]));
+            cmpt[c].dx = fc.dx;
+            cmpt[c].dy = fc.dy;
+            cmpt[c].w = fc.w;
+            cmpt[c].h = fc.h;
+            cmpt[c].x0 = fc.x0;
+            cmpt[c].y0 = fc.y0;
+            cmpt[c].prec = fc.prec;
+            cmpt[c].sgnd = fc.sgnd;
+            samples_bytes += (OPJ_UINT64)fc.w * fc.h * fc.bytesPerSample;
+        }
+        if (samples_bytes != size - offset) return nullptr;
+
+        opj_image_t* image = opj_image_create(header.numcomps, cmpt.data(), (OPJ_COLOR_SPACE)header.colorSpace);
+        if (!image) return nullptr;
+        image->x0 = header.x0;
+        image->y0 = header.y0;
+        image->x1 = header.x1;
+        image->y1 = header.y1;
+        for (OPJ_UINT32 c = 0; c < header.numcomps; c++) {
+            CacheFileComponent const& fc = comps[c];
+            opj_image_comp_t& ic = image->comps[c];
+            ic.factor = fc.factor;
+            ic.alpha = (OPJ_UINT16)fc.alpha;
+            OPJ_SIZE_T count = (OPJ_SIZE_T)fc.w * fc.h;
+            switch (fc.bytesPerSample) {
+            case 1: fc.sgnd ? widen_samples<OPJ_INT8>(ic.data, data + offset, count) : widen_samples<OPJ_BYTE>(ic.data, data + offset, count); break;
+            case 2: fc.sgnd ? widen_samples<OPJ_INT16>(ic.data, data + offset, count) : widen_samples<OPJ_UINT16>(ic.data, data + offset, count); break;
+            default: widen_samples<OPJ_INT32>(ic.data, data + offset, count); break;
+            }
+            offset += count * fc.bytesPerSample;
+        }
+        return image;
+    }
+} // namespace
+
+struct TextureCache {
+    struct Entry {
+        std::list<std::string>::iterator lru;
+        OPJ_UINT64 bytes = 0;
+    };
+
+    fs::path mDirectory;
+    OPJ_UINT64 mMaxBytes = 0;
+
+    mutable std::mutex mMutex;       // guards everything below
+    std::list<std::string> mLru;     // keys, most recently used first
+    std::unordered_map<std::string, Entry> mEntries;
+    TextureCacheStats mStats;
+    OPJ_UINT64 mTempCounter = 0;
+
+    fs::path pathOf(std::string const& key) const {
+        return mDirectory / (key + CACHE_EXTENSION);
+    }
+
+    // caller holds mMutex
+    void insert(std::string const& key, OPJ_UINT64 bytes) {
+        auto it = mEntries.find(key);
+        if (it != mEntries.end()) {
+            mStats.bytes -= it->second.bytes;
+            mLru.erase(it->second.lru);
+            mEntries.erase(it);
+        }
+        mLru.push_front(key);
+        mEntries[key] = Entry{ mLru.begin(), bytes };
+        mStats.bytes += bytes;
+        mStats.entries = mEntries.size();
+    }
+
+    // caller holds mMutex; the entry's file is added to doomed, for
+    // deleteFiles() once mMutex is released (lookups and stores on other
+    // threads should not wait on the filesystem)
+    void remove(std::string const& key, std::vector<fs::path>& doomed) {
+        auto it = mEntries.find(key);
+        if (it == mEntries.end()) return;
+        mStats.bytes -= it->second.bytes;
+        mLru.erase(it->second.lru);
+        mEntries.erase(it);
+        mStats.entries = mEntries.size();
+        doomed.push_back(pathOf(key));
+    }
+
+    // caller holds mMutex
+    void evictToBudget(std::vector<fs::path>& doomed) {
+        while (mStats.bytes > mMaxBytes && !mLru.empty()) {
+            remove(mLru.back(), doomed);
+            mStats.evictions++;
+        }
+    }
+
+    // without mMutex; should a store of the same key land in between, its
+    // file goes too, and the next load of it misses and drops the entry
+    static void deleteFiles(std::vector<fs::path> const& doomed) {
+        for (fs::path const& path : doomed) {
+            std::error_code ec;
+            fs::remove(path, ec);
+        }
+    }
+
+    // rebuilds the index from the directory, oldest modification time = least recently used
+    void scan() {
+        std::error_code ec;
+        std::vector<std::pair<fs::file_time_type, std::pair<std::string, OPJ_UINT64>>> found;
+        for (fs::directory_entry const& entry : fs::directory_iterator(mDirectory, ec)) {
+            fs::path const& path = entry.path();
+            if (path.extension() == ".tmp") {
+                std::error_code ignored;
+                fs::remove(path, ignored); // left behind by an interrupted store
+                continue;
+            }
+            if (path.extension() != CACHE_EXTENSION) continue;
+            std::error_code stat_ec;
+            OPJ_UINT64 bytes = (OPJ_UINT64)entry.file_size(stat_ec);
+            fs::file_time_type mtime = entry.last_write_time(stat_ec);
+            if (stat_ec) continue;
+            found.push_back({ mtime, { path.stem().string(), bytes } });
+        }
+        std::sort(found.begin(), found.end(), [](auto const& a, auto const& b) { return a.first < b.first; });
+        std::vector<fs::path> doomed;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            for (auto const& it : found) insert(it.second.first, it.second.second);
+            evictToBudget(doomed);
+        }
+        deleteFiles(doomed);
+    }
+};
+
+TextureCache* createTextureCache(TextureCacheOptions const& options) {
+    if (options.directory.empty()) return nullptr;
+    auto cache = std::make_unique<TextureCache>();
+    cache->mDirectory = fs::path(options.directory);
+    cache->mMaxBytes = options.maxBytes;
+    std::error_code ec;
+    fs::create_directories(cache->mDirectory, ec);
+    if (!fs::is_directory(cache->mDirectory, ec)) return nullptr;
+    cache->scan();
+    return cache.release();
+}
+
+void destroyTextureCache(TextureCache* cache) {
+    delete cache;
+}
+
+opj_image_t* loadCached(TextureCache* cache, std::string const& uuid, OPJ_UINT32 discard, OPJ_UINT64 sourceSize) {
+    if (!cache || !valid_uuid(uuid)) return nullptr;
+    auto start = std::chrono::steady_clock::now();
+    std::string key = entry_key(uuid, discard);
+    fs::path path;
+    {
+        std::lock_guard<std::mutex> lock(cache->mMutex);
+        auto it = cache->mEntries.find(key);
+        if (it == cache->mEntries.end()) {
+            cache->mStats.misses++;
+            return nullptr;
+        }
+        cache->mLru.splice(cache->mLru.begin(), cache->mLru, it->second.lru);
+        path = cache->pathOf(key);
+    }
+
+    MappedFile* file = mapFile(path.string().c_str());
+    opj_image_t* image = file ? deserialize_image(mappedData(file), mappedSize(file), discard, sourceSize) : nullptr;
+    unmapFile(file);
+
+    if (!image) {
+        std::vector<fs::path> doomed;
+        {
+            std::lock_guard<std::mutex> lock(cache->mMutex);
+            cache->remove(key, doomed);
+            cache->mStats.rejected++;
+            cache->mStats.misses++;
+        }
+        TextureCache::deleteFiles(doomed);
+        return nullptr;
+    }
+    std::error_code ec;
+    fs::last_write_time(path, fs::file_time_type::clock::now(), ec); // persists the recency
+    std::lock_guard<std::mutex> lock(cache->mMutex);
+    cache->mStats.hits++;
+    cache->mStats.loadSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return image;
+}
+
+bool storeCached(TextureCache* cache, std::string const& uuid, OPJ_UINT32 discard, opj_image_t const* image, OPJ_UINT64 sourceSize) {
+    if (!cache || !valid_uuid(uuid)) return false;
+    std::vector<OPJ_BYTE> bytes = serialize_image(image, discard, sourceSize);
+    if (bytes.empty() || bytes.size() > cache->mMaxBytes) return false;
+
+    std::string key = entry_key(uuid, discard);
+    fs::path path = cache->pathOf(key);
+    fs::path temp;
+    {
+        std::lock_guard<std::mutex> lock(cache->mMutex);
+        temp = cache->mDirectory / (key + "." + std::to_string(cache->mTempCounter++) + ".tmp");
+    }
+    {
+        std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+        out.write((const char*)bytes.data(), (std::streamsize)bytes.size());
+        if (!out) {
+            out.close();
+            std::error_code ec;
+            fs::remove(temp, ec);
+            return false;
+        }
+    }
+    std::error_code ec;
+    fs::rename(temp, path, ec);
+    if (ec) {
+        fs::remove(temp, ec);
+        return false;
+    }
+
+    std::vector<fs::path> doomed;
+    {
+        std::lock_guard<std::mutex> lock(cache->mMutex);
+        cache->insert(key, bytes.size());
+        cache->mStats.stores++;
+        cache->evictToBudget(doomed);
+    }
+    TextureCache::deleteFiles(doomed);
+    return true;
+}
+
+opj_image_t* decodeCached(TextureCache* cache, DecoderContext* ctx, std::string const& uuid, const OPJ_BYTE* data, OPJ_SIZE_T size, DecodeParams const& params) {
+    bool cacheable = cache && params.layers == 0 && valid_uuid(uuid);
+    if (cacheable) {
+        if (opj_image_t* image = loadCached(cache, uuid, params.reduce, size)) return image;
+    }
+    auto start = std::chrono::steady_clock::now();
+    opj_image_t* image = decode(ctx, data, size, params);
+    if (image && cacheable) storeCached(cache, uuid, params.reduce, image, size);
+    if (cache) {
+        std::lock_guard<std::mutex> lock(cache->mMutex);
+        cache->mStats.decodeSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+    return image;
+}
+
+TextureCacheStats stats(TextureCache const* cache) {
+    std::lock_guard<std::mutex> lock(cache->mMutex);
+    return cache->mStats;
+}
+
+void resetStats(TextureCache* cache) {
+    std::lock_guard<std::mutex> lock(cache->mMutex);
+    OPJ_UINT64 entries = cache->mStats.entries, bytes = cache->mStats.bytes;
+    cache->mStats = TextureCacheStats{};
+    cache->mStats.entries = entries;
+    cache->mStats.bytes = bytes;
+}
+
+} // namespace openjp2_api
@@ -20,6 +20,23 @@
   #define WIN64
   #pragma include_alias("openvr.h", "openvr_api/headers/openvr.h")
   #include "openvr_api/headers/openvr.h"
+
+  // openvr_api extensions (defined below with OPENVR_API_IMPLEMENTATION)
+  namespace openvr_api {
+    // VR_Init (and VR_IsRuntimeInstalled / VR_RuntimePath) re-read and parse
+    // openvrpaths.vrpath on every call; instead the first successful read is
+    // kept and reused until discarded
+    struct RuntimePathsStats {
+      unsigned reads = 0;        // registry actually read + parsed
+      unsigned hits = 0;         // lookups answered from the cache
+      double readSeconds = 0.0;  // duration of the most recent read
+    };
+    // reads the registry now (if not cached yet); safe to run on a worker thread
+    bool prefetchRuntimePaths();
+    // forget the cached paths (e.g. after VR_Init reports the runtime moved)
+    void discardRuntimePaths();
+    RuntimePathsStats runtimePathsStats();
+  } // namespace openvr_api
 #endif // OPENVR_API_OPENVR_H
 
 // ===========================================================================
@@ -34,7 +51,75 @@
   #pragma include_alias("vrpathregistry_public.h", "openvr_api/src/vrcommon/vrpathregistry_public.h")
   #pragma include_alias("json/json.h",             "openvr_api/src/json/json.h")
 
+  #include <chrono>
+  #include <mutex>
+  #include <string>
+  #include <vector>
+  #include "openvr_api/src/vrcommon/vrpathregistry_public.h"
+
+  namespace openvr_api {
+    namespace {
+      struct RuntimePathsCache {
+        std::mutex mutex;
+        bool valid = false;
+        std::string runtime, config, log;
+        RuntimePathsStats stats;
+      };
+      RuntimePathsCache& runtime_paths_cache() {
+        static RuntimePathsCache cache;
+        return cache;
+      }
+      // caller holds cache.mutex
+      bool runtime_paths_read(RuntimePathsCache& cache) {
+        auto start = std::chrono::steady_clock::now();
+        cache.valid = CVRPathRegistry_Public::GetPaths(&cache.runtime, &cache.config, &cache.log, nullptr, nullptr);
+        cache.stats.reads++;
+        cache.stats.readSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return cache.valid;
+      }
+    } // namespace
+
+    // stands in for CVRPathRegistry_Public inside openvr_api_public.cpp;
+    // failures are not cached so installing SteamVR later is still picked up
+    struct CachedVRPathRegistry {
+      static bool GetPaths(std::string* psRuntimePath, std::string* psConfigPath, std::string* psLogPath,
+                           const char* pchConfigPathOverride, const char* pchLogPathOverride,
+                           std::vector<std::string>* pvecExternalDrivers = nullptr) {
+        if (pchConfigPathOverride || pchLogPathOverride || pvecExternalDrivers)
+          return CVRPathRegistry_Public::GetPaths(psRuntimePath, psConfigPath, psLogPath, pchConfigPathOverride, pchLogPathOverride, pvecExternalDrivers);
+        auto& cache = runtime_paths_cache();
+        std::lock_guard<std::mutex> lock(cache.mutex);
+        if (cache.valid) cache.stats.hits++;
+        else if (!runtime_paths_read(cache)) return false;
+        if (psRuntimePath) *psRuntimePath = cache.runtime;
+        if (psConfigPath) *psConfigPath = cache.config;
+        if (psLogPath) *psLogPath = cache.log;
+        return true;
+      }
+    };
+
+    bool prefetchRuntimePaths() {
+      auto& cache = runtime_paths_cache();
+      std::lock_guard<std::mutex> lock(cache.mutex);
+      return cache.valid || runtime_paths_read(cache);
+    }
+
+    void discardRuntimePaths() {
+      auto& cache = runtime_paths_cache();
+      std::lock_guard<std::mutex> lock(cache.mutex);
+      cache.valid = false;
+    }
+
+    RuntimePathsStats runtimePathsStats() {
+      auto& cache = runtime_paths_cache();
+      std::lock_guard<std::mutex> lock(cache.mutex);
+      return cache.stats;
+    }
+  } // namespace openvr_api
+
+#define CVRPathRegistry_Public ::openvr_api::CachedVRPathRegistry
   #include "openvr_api/src/openvr_api_public.cpp"
+#undef CVRPathRegistry_Public
   #include "openvr_api/src/vrcommon/dirtools_public.cpp"
   #include "openvr_api/src/vrcommon/envvartools_public.cpp"
   #include "openvr_api/src/vrcommon/hmderrors_public.cpp"
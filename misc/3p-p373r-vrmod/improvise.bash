@@ -37,6 +37,19 @@ function provision_p373r_vrmod() {(
    include/llviewerVR.h
    include/llviewerVR.cpp
    include/llviewerVR.vrmod_settings.c++
+   include/llviewerVR.vrmod_telemetry.c++
+   include/llviewerVR.vrmod_projection.c++
+   include/llviewerVR.vrmod_pointer.c++
+   include/llviewerVR.vrmod_input.c++
+   include/llviewerVR.vrmod_overlay.c++
+   include/llviewerVR.vrmod_ui.c++
+   include/llviewerVR.vrmod_farfield.c++
+   include/llviewerVR.vrmod_cull.c++
+   include/llviewerVR.vrmod_passes.c++
+   include/llviewerVR.vrmod_posetrace.c++
+   include/llviewerVR.vrmod_capture.c++
+   include/llviewerVR.vrmod_runtime.c++
+   include/llviewerVR.vrmod_hitch.c++
   )
 
   for x in ${FILES[@]} ; do test -s stage/$x || { echo "'$x' invalid" >&2 ; exit 38 ; } ; done || return 61